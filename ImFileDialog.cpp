@@ -14,9 +14,21 @@
 
 #include <cmath>
 #include <array>
+#include <cerrno>
+#include <clocale>
+#include <cstring>
 #include <fstream>
 #include <algorithm>
+#include <bit>
+#include <unordered_set>
+#include <deque>
+#include <optional>
+#include <condition_variable>
 #include <sys/stat.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IFD_SSE2
+#endif
 #ifdef _WIN32
 #include <windows.h>
 #include <shellapi.h>
@@ -26,10 +38,17 @@
 #include <gio/gio.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
 #elif defined(__APPLE__)
 #include <AppKit/AppKit.h>
+#include <sys/mount.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
 #ifdef USE_GETTEXT
@@ -45,17 +64,50 @@ namespace ifd {
 	constexpr auto EXTRA_SIZE_FOR_ICON = 3.0f;
 	constexpr auto EXTRA_SIZE_FOR_ELEMENT = 10.0f;
 	constexpr auto ELEMENT_MAX_SIZE = 24.0f;
-	constexpr auto IMGUI_LIGHT_THEME_WINDOW_BG = ImVec4(0.94f, 0.94f, 0.94f, 1.00f);
 	constexpr auto DEFAULT_ICON_CHANNELS = 4;
-	constexpr auto RGB_MASK = 0xFFFFFFU;
-	constexpr auto ALPHA_MASK = 0xFF000000U;
 	constexpr auto MOUSE_WHEEL_NOT_SCROLLING = 0.0f;
 	constexpr auto ZOOM_LEVEL_RENDER_PREVIEW = 5.0f;
 	constexpr auto ZOOM_LEVEL_LIST_VIEW = 1.0f;
 	constexpr auto APPLE_ICON_DEFAULT_SCALE_LEVEL = 8;
-	constexpr auto NUM_SYSTEM_ICON_PATH = 3;
-	constexpr auto USER_ICON_PATH = "~/.icons";
-	constexpr auto GLOBAL_ICON_PATH = "/usr/share/icons";
+	constexpr auto ICON_ATLAS_CELL_SIZE = DEFAULT_ICON_SIZE * 2; // keeps detail when zoomed in, 32px icons are doubled exactly
+	constexpr auto ICON_ATLAS_CELL_STRIDE = ICON_ATLAS_CELL_SIZE + 2; // one pixel border repeating the edge, filtering doesn't bleed into neighbours
+	constexpr auto ICON_ATLAS_PAGE_WIDTH = 1024;
+	constexpr auto ICON_ATLAS_COLUMNS = ICON_ATLAS_PAGE_WIDTH / ICON_ATLAS_CELL_STRIDE;
+	constexpr auto ICON_ATLAS_INITIAL_ROWS = 2u;
+	constexpr auto ICON_ATLAS_MAX_ROWS = 15u; // page height stays within 1024 pixels
+	constexpr auto FALLBACK_ICON_THEME = "hicolor"; // every theme inherits it, see the icon theme specification
+	constexpr auto PIXMAPS_PATH = "/usr/share/pixmaps"; // unthemed icons, looked up last
+	constexpr auto CONTENT_LOADER_CHUNK_SIZE = 256;
+	constexpr size_t DEFAULT_LISTING_CACHE_MAX_ENTRIES = 1000000;
+	constexpr size_t DEFAULT_LISTING_CACHE_MAX_BYTES = 256 * 1024 * 1024;
+	constexpr size_t DEFAULT_ICON_CACHE_MAX_ICONS = 512;
+	constexpr size_t DEFAULT_ICON_CACHE_MAX_BYTES = 16 * 1024 * 1024;
+	constexpr auto NO_MATCH = -1;
+	constexpr auto SCORE_MATCH = 16;
+	constexpr auto BONUS_START = 32;
+	constexpr auto BONUS_BOUNDARY = 24;
+	constexpr auto BONUS_CONSECUTIVE = 16;
+	constexpr auto MAX_GAP_PENALTY = 8;
+	constexpr size_t MAX_SELECTION_TEXT_NAMES = 32; // the file name box lists at most this many selected names
+	constexpr auto NO_DISPLAY_TEXT = UINT32_MAX;
+	constexpr auto WATCH_POLL_INTERVAL = std::chrono::seconds(1); // how often the directory's stamp is checked without inotify
+	constexpr size_t WATCH_BUFFER_SIZE = 16 * 1024;
+	constexpr auto WALK_CANCEL_CHECK = std::chrono::milliseconds(10); // how often idle walkers notice a cancelled walk
+	constexpr size_t PARALLEL_SORT_THRESHOLD = 32768; // entries, smaller listings are sorted on the render thread alone
+	constexpr char LISTING_INDEX_MAGIC[8] = {'I', 'F', 'D', 'I', 'N', 'D', 'E', 'X'};
+	constexpr uint32_t LISTING_INDEX_VERSION = 1;
+	constexpr size_t MAX_FOLDER_SIZE_CACHE_ENTRIES = 65536; // the cache starts over when it grows past this
+	constexpr char ICON_CACHE_MAGIC[8] = {'I', 'F', 'D', 'I', 'C', 'O', 'N', 'S'};
+	constexpr uint32_t ICON_CACHE_VERSION = 1;
+	constexpr size_t ICON_CACHE_BITMAP_SIZE = ICON_ATLAS_CELL_SIZE * ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS; // one atlas cell without its border
+	constexpr auto LISTING_INDEX_STALE_TEMP = std::chrono::minutes(10); // temporary files left behind by a crashed writer
+	constexpr auto FILE_STAT_TIMEOUT = std::chrono::milliseconds(50); // single file system calls made while drawing a frame
+	constexpr auto FILE_LIST_TIMEOUT = std::chrono::milliseconds(250); // whole directories read while drawing a frame
+	constexpr auto FILE_CHANGE_TIMEOUT = std::chrono::seconds(5); // creating and deleting, asked for by the user
+	constexpr auto LOADER_STALL_TIMEOUT = std::chrono::seconds(3); // a loader without progress for this long is stuck
+	constexpr auto ICON_QUERY_TIMEOUT = std::chrono::seconds(1); // asked by the icon loader, nothing waits for it while drawing
+	constexpr auto FILE_WORKER_IDLE_TIMEOUT = std::chrono::seconds(30);
+	constexpr auto MOUNT_TABLE_REFRESH = std::chrono::seconds(5);
 
 	enum class SizeUnit : uint8_t {
 		B = 0,
@@ -66,15 +118,41 @@ namespace ifd {
 	};
 
 #ifdef __linux__
+	void onIconThemeChanged(GSettings*, const gchar*, gpointer changed)
+	{
+		*static_cast<bool*>(changed) = true;
+	}
+
+	// Read once, then again only after GSettings reports a change. The signal is dispatched from a private main
+	// context iterated here, the application doesn't have to run a GLib main loop.
 	std::string getIconTheme() 
 	{
-		const auto settings = g_settings_new("org.gnome.desktop.interface");
-		if (!settings) {
-			fprintf(stderr, "Error creating GSettings object\n");
-			return {};
+		static GMainContext* context = nullptr;
+		static GSettings* settings = nullptr;
+		static bool changed = true;
+		static std::string iconTheme;
+
+		if (context == nullptr) {
+			context = g_main_context_new();
+			g_main_context_push_thread_default(context); // settings deliver their signals to this context
+			settings = g_settings_new("org.gnome.desktop.interface");
+			if (settings) {
+				g_signal_connect(settings, "changed::icon-theme", G_CALLBACK(onIconThemeChanged), &changed);
+			} else {
+				fprintf(stderr, "Error creating GSettings object\n");
+			}
+			g_main_context_pop_thread_default(context);
+		}
+
+		while (g_main_context_iteration(context, FALSE)) {
+		}
+
+		if (changed && settings) {
+			changed = false;
+			gchar* name = g_settings_get_string(settings, "icon-theme");
+			iconTheme = name != nullptr ? name : "";
+			g_free(name);
 		}
-		const auto iconTheme = g_settings_get_string(settings, "icon-theme");
-		g_object_unref(settings);
 		return iconTheme;
 	}
 #endif
@@ -177,553 +255,2058 @@ namespace ifd {
 		return std::max<float>(fontSize + EXTRA_SIZE_FOR_ELEMENT, ELEMENT_MAX_SIZE);
 	}
 
-	/* UI CONTROLS */
-	bool folderNode(const char* label, ImTextureID icon, bool& clicked)
+	// The default icons are black shapes, only their alpha matters: every pixel gets the colour of tint (an
+	// ImU32, RGBA in memory) and its alpha scaled by tint's. Four pixels per step with SSE2.
+	void tintIcon(const uint32_t* icon, size_t size, uint32_t tint, uint32_t* out)
 	{
-		ImGuiContext& g = *GImGui;
-		ImGuiWindow* window = g.CurrentWindow;
-
-		clicked = false;
-
-		ImU32 id = window->GetID(label);
-		int opened = window->StateStorage.GetInt(id, 0);
-		ImVec2 pos = window->DC.CursorPos;
-		const bool is_mouse_x_over_arrow = (g.IO.MousePos.x >= pos.x && g.IO.MousePos.x < pos.x + g.FontSize);
+		const uint32_t color = tint & 0x00FFFFFFU;
+		const uint32_t alpha = tint >> 24;
+		size_t i = 0;
+#ifdef IFD_SSE2
+		const __m128i colors = _mm_set1_epi32(static_cast<int>(color));
+		const __m128i alphas = _mm_set1_epi32(static_cast<int>(alpha));
+		const __m128i half = _mm_set1_epi32(128);
+		for (; i + 4 <= size; i += 4) {
+			__m128i scaled = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(icon + i)), 24);
+			scaled = _mm_add_epi32(_mm_mullo_epi16(scaled, alphas), half); // both below 256, the product fits the low 16 bits
+			scaled = _mm_srli_epi32(_mm_add_epi32(scaled, _mm_srli_epi32(scaled, 8)), 8); // rounded division by 255
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(_mm_slli_epi32(scaled, 24), colors));
+		}
+#endif
+		for (; i < size; i++) {
+			uint32_t scaled = (icon[i] >> 24) * alpha + 128;
+			scaled = (scaled + (scaled >> 8)) >> 8;
+			out[i] = (scaled << 24) | color;
+		}
+	}
 
-		if (ImGui::InvisibleButton(label, ImVec2(-FLT_MIN, g.FontSize + g.Style.FramePadding.y * 2)))
-		{
-			if (is_mouse_x_over_arrow) {
-				int* p_opened = window->StateStorage.GetIntRef(id, 0);
-				opened = *p_opened = !*p_opened;
-			} else {
-				clicked = true;
+	/* SEARCH */
+	// simple (1:1) case folding for ASCII, Latin-1, Latin Extended-A, Greek, Cyrillic and fullwidth Latin
+	char32_t foldCodepoint(char32_t c)
+	{
+		if (c < 0x80) {
+			return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+		} else if (c >= 0xC0 && c <= 0xDE && c != 0xD7) {
+			return c + 0x20;
+		} else if (c >= 0x100 && c <= 0x17F) {
+			if (c == 0x130) {
+				return 'i';
+			} else if (c == 0x178) {
+				return 0xFF;
+			} else if (c == 0x17F) {
+				return 's'; // long s
+			} else if (c == 0x131 || c == 0x138 || c == 0x149) {
+				return c;
+			} else if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) {
+				return (c & 1) ? c + 1 : c;
+			}
+			return c | 1;
+		} else if (c >= 0x386 && c <= 0x3AB) {
+			if (c == 0x386) {
+				return 0x3AC;
+			} else if (c >= 0x388 && c <= 0x38A) {
+				return c + 0x25;
+			} else if (c == 0x38C) {
+				return 0x3CC;
+			} else if (c == 0x38E || c == 0x38F) {
+				return c + 0x3F;
+			} else if (c >= 0x391 && c != 0x3A2) {
+				return c + 0x20;
 			}
+		} else if (c == 0x3C2) {
+			return 0x3C3; // final sigma
+		} else if (c >= 0x400 && c <= 0x40F) {
+			return c + 0x50;
+		} else if (c >= 0x410 && c <= 0x42F) {
+			return c + 0x20;
+		} else if (c >= 0xFF21 && c <= 0xFF3A) {
+			return c + 0x20;
 		}
 
-		bool hovered = ImGui::IsItemHovered();
-		bool active = ImGui::IsItemActive();
-		bool doubleClick = ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left);
+		return c;
+	}
 
-		if (doubleClick && hovered) {
-			int* p_opened = window->StateStorage.GetIntRef(id, 0);
-			opened = *p_opened = !*p_opened;
-			clicked = false;
-		}
+	// into ret, which is cleared first, so a buffer reused across calls doesn't allocate once it's large enough
+	void foldCase(std::string_view text, std::string& ret)
+	{
+		ret.clear();
+		ret.reserve(text.size());
 
-		if (hovered || active) {
-			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
-											g.LastItemData.Rect.Max, 
-											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]));
-		}
-					
-		// Icon, text
-		float icon_posX = pos.x + g.FontSize + g.Style.FramePadding.y;
-		float text_posX = icon_posX + g.Style.FramePadding.y + computeIconSize(ImGui::GetFont()->FontSize);
-		ImGui::RenderArrow(window->DrawList, ImVec2(pos.x, pos.y+g.Style.FramePadding.y), ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[((hovered && is_mouse_x_over_arrow) || opened) ? ImGuiCol_Text : ImGuiCol_TextDisabled]), opened ? ImGuiDir_Down : ImGuiDir_Right);
-		window->DrawList->AddImage(icon, ImVec2(icon_posX, pos.y), ImVec2(icon_posX + computeIconSize(ImGui::GetFont()->FontSize), pos.y + computeIconSize(ImGui::GetFont()->FontSize)));
-		ImGui::RenderText(ImVec2(text_posX, pos.y + g.Style.FramePadding.y), label);
-		
-		if (opened) {
-			ImGui::TreePush(label);
-		}
-			
-		return opened != 0;
-	}
+		for (size_t i = 0; i < text.size();) {
+			const auto lead = static_cast<unsigned char>(text[i]);
+			size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
 
-	bool fileNode(const char* label, ImTextureID icon) {
-		ImGuiContext& g = *GImGui;
-		ImGuiWindow* window = g.CurrentWindow;
+			bool valid = length > 0 && i + length <= text.size();
+			for (size_t j = 1; valid && j < length; j++) {
+				valid = (static_cast<unsigned char>(text[i + j]) & 0xC0) == 0x80;
+			}
 
-		//ImU32 id = window->GetID(label);
-		ImVec2 pos = window->DC.CursorPos;
-		bool ret = ImGui::InvisibleButton(label, ImVec2(-FLT_MIN, g.FontSize + g.Style.FramePadding.y * 2));
+			// keep invalid sequences as they are
+			if (!valid) {
+				ret.push_back(text[i++]);
+				continue;
+			}
 
-		bool hovered = ImGui::IsItemHovered();
-		bool active = ImGui::IsItemActive();
+			char32_t c = length == 1 ? lead : lead & (0xFF >> (length + 1));
+			for (size_t j = 1; j < length; j++) {
+				c = (c << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+			}
+			c = foldCodepoint(c);
+
+			if (c < 0x80) {
+				ret.push_back(static_cast<char>(c));
+			} else if (c < 0x800) {
+				ret.push_back(static_cast<char>(0xC0 | (c >> 6)));
+				ret.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			} else if (c < 0x10000) {
+				ret.push_back(static_cast<char>(0xE0 | (c >> 12)));
+				ret.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+				ret.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			} else {
+				ret.push_back(static_cast<char>(0xF0 | (c >> 18)));
+				ret.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+				ret.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+				ret.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+			}
 
-		if (hovered || active) {
-			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
-											g.LastItemData.Rect.Max, 
-											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]));
+			i += length;
 		}
-			
-		// Icon, text
-		window->DrawList->AddImage(icon, ImVec2(pos.x, pos.y), ImVec2(pos.x + computeIconSize(ImGui::GetFont()->FontSize), pos.y + computeIconSize(ImGui::GetFont()->FontSize)));
-		ImGui::RenderText(ImVec2(pos.x + g.Style.FramePadding.y + computeIconSize(ImGui::GetFont()->FontSize), pos.y + g.Style.FramePadding.y), label);
-		
-		return ret;
 	}
 
-	bool pathBox(const char* label, std::filesystem::path& path, std::string& pathBuffer, ImVec2 size_arg) {
-		ImGuiWindow* window = ImGui::GetCurrentWindow();
+	std::string foldCase(std::string_view text)
+	{
+		std::string ret;
+		foldCase(text, ret);
+		return ret;
+	}
 
-		if (window->SkipItems) {
-			return false;
+	// one bit per letter/digit, the remaining bytes share the upper bits. A key can only contain
+	// the query as a subsequence if it has every bit of the query, so most entries are rejected
+	// with a single AND before the matcher looks at them.
+	uint64_t characterMask(std::string_view foldedText)
+	{
+		uint64_t mask = 0;
+		for (const auto ch : foldedText) {
+			const auto c = static_cast<unsigned char>(ch);
+			if (c >= 'a' && c <= 'z') {
+				mask |= 1ULL << (c - 'a');
+			} else if (c >= '0' && c <= '9') {
+				mask |= 1ULL << (26 + c - '0');
+			} else {
+				mask |= 1ULL << (36 + c % 28);
+			}
 		}
+		return mask;
+	}
 
-		bool ret = false;
-		const ImGuiID id = window->GetID(label);
-		int* state = window->StateStorage.GetIntRef(id, 0);
-		
-		ImGui::SameLine();
-
-		ImGuiContext& g = *GImGui;
-		const ImGuiStyle& style = g.Style;
-		ImVec2 pos = window->DC.CursorPos;
-		ImVec2 uiPos = ImGui::GetCursorPos();
-		ImVec2 size = ImGui::CalcItemSize(size_arg, 200, computeGuiElementSize(GImGui->FontSize));
-		const ImRect bb(pos, pos + size);
-		
-		// buttons
-		if (!(*state & 0b001)) {
-			ImGui::PushClipRect(bb.Min, bb.Max, false);
+	bool isWordBoundary(char c)
+	{
+		return c == ' ' || c == '_' || c == '-' || c == '.' || c == '(' || c == '[';
+	}
 
-			// background
-			bool hovered = g.IO.MousePos.x >= bb.Min.x && g.IO.MousePos.x <= bb.Max.x &&
-				g.IO.MousePos.y >= bb.Min.y && g.IO.MousePos.y <= bb.Max.y;
-			bool clicked = hovered && ImGui::IsMouseReleased(ImGuiMouseButton_Left);
-			bool anyOtherHC = false; // are any other items hovered or clicked?
-			window->DrawList->AddRectFilled(pos, pos + size, ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[(*state & 0b10) ? ImGuiCol_FrameBgHovered : ImGuiCol_FrameBg]));
+	// score of query code points found one after another at increasing offsets of key
+	struct MatchScore {
+		MatchScore(std::string_view key) : key{key} {}
 
-			// fetch the buttons (so that we can throw some away if needed)
-			std::vector<std::string> btnList;
-			float totalWidth = 0.0f;
-			for (auto comp : path) {
-				std::string section = comp.u8string();
+		void add(size_t pos, size_t length)
+		{
+			score += SCORE_MATCH;
+			if (pos == 0) {
+				score += BONUS_START;
+			} else if (isWordBoundary(key[pos - 1])) {
+				score += BONUS_BOUNDARY;
+			}
 
-				if (section.size() == 1 && (section[0] == '\\' || section[0] == '/')) {
-					continue;
+			if (matched) {
+				if (pos == previousEnd) {
+					score += BONUS_CONSECUTIVE;
+				} else {
+					score -= static_cast<int>(std::min<size_t>(pos - previousEnd, MAX_GAP_PENALTY));
 				}
-					
-				totalWidth += ImGui::CalcTextSize(section.c_str()).x + style.FramePadding.x * 2.0f + computeGuiElementSize(GImGui->FontSize);
-				btnList.push_back(section);
 			}
-			totalWidth -= computeGuiElementSize(GImGui->FontSize);
 
-			// UI buttons
-			ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, ImGui::GetStyle().ItemSpacing.y));
-			ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
-			bool isFirstElement = true;
-			for (size_t i = 0; i < btnList.size(); i++) {
-				if (totalWidth > size.x - 30 && i != btnList.size() - 1) { // trim some buttons if there's not enough space
-					float elSize = ImGui::CalcTextSize(btnList[i].c_str()).x + style.FramePadding.x * 2.0f + computeGuiElementSize(GImGui->FontSize);
-					totalWidth -= elSize;
-					continue;
-				}
+			matched = true;
+			previousEnd = pos + length;
+		}
 
-				ImGui::PushID(static_cast<int>(i));
+		// prefer shorter names when everything else is equal
+		int result() const { return score - static_cast<int>(key.size() / 8); }
 
-				if (!isFirstElement) {
-					ImGui::ArrowButtonEx("##dir_dropdown", ImGuiDir_Right, ImVec2(computeGuiElementSize(GImGui->FontSize), computeGuiElementSize(GImGui->FontSize)));
-					anyOtherHC |= ImGui::IsItemHovered() | ImGui::IsItemClicked();
-					ImGui::SameLine();
-				}
+		std::string_view key;
+		int score = 0;
+		size_t previousEnd = 0;
+		bool matched = false;
+	};
 
-				if (ImGui::Button(btnList[i].c_str(), ImVec2(0, computeGuiElementSize(GImGui->FontSize)))) {
-#ifdef _WIN32
-					std::string newPath = "";
-#else
-					std::string newPath = "/";
-#endif
-					for (size_t j = 0; j <= i; j++) {
-						newPath += btnList[j];
-#ifdef _WIN32
-						if (j != i) {
-							newPath += "\\";
-						}
-#else
-						if (j != i) {
-							newPath += "/";
-						}
-#endif
-					}
-					path = std::filesystem::u8path(newPath);
-					ret = true;
-				}
+	// byte length of the UTF-8 code point starting at text[i]
+	inline size_t codepointLength(std::string_view text, size_t i)
+	{
+		size_t length = 1;
+		while (i + length < text.size() && (static_cast<unsigned char>(text[i + length]) & 0xC0) == 0x80) {
+			length++;
+		}
+		return length;
+	}
 
-				anyOtherHC |= ImGui::IsItemHovered() | ImGui::IsItemClicked();
-				ImGui::SameLine();
-				ImGui::PopID();
+	// Fuzzy subsequence match of an already folded query against an already folded key.
+	// Returns NO_MATCH or a score, higher is better. Runs once per entry on every keystroke,
+	// so the score is kept as the code points are found instead of storing their offsets.
+	int fuzzyMatch(std::string_view key, std::string_view query)
+	{
+		if (query.empty()) {
+			return 0;
+		}
 
-				isFirstElement = false;
+		// find each query code point in order, string_view::find uses memchr which libc vectorizes
+		MatchScore subsequence{key};
+		size_t first = std::string_view::npos;
+		size_t pos = 0;
+		for (size_t i = 0; i < query.size();) {
+			const size_t length = codepointLength(query, i);
+
+			pos = key.find(query.substr(i, length), pos);
+			if (pos == std::string_view::npos) {
+				return NO_MATCH;
 			}
-			ImGui::PopStyleVar(2);
 
+			first = std::min(first, pos);
+			subsequence.add(pos, length);
+			pos += length;
+			i += length;
+		}
 
-			// click state
-			if (!anyOtherHC && clicked) {
-				pathBuffer = path.u8string();
-				*state |= 0b001;
-				*state &= 0b011; // remove SetKeyboardFocus flag
-			} else {
-				*state &= 0b110;
-			}
+		int score = subsequence.result();
 
-			// hover state
-			if (!anyOtherHC && hovered && !clicked) {
-				*state |= 0b010;
-			} else {
-				*state &= 0b101;
+		// the leftmost subsequence can be worse than a later substring hit ("a_b_ab" for "ab")
+		if (const auto substring = key.find(query); substring != std::string_view::npos && substring != first) {
+			MatchScore contiguous{key};
+			for (size_t i = 0; i < query.size();) {
+				const size_t length = codepointLength(query, i);
+				contiguous.add(substring + i, length);
+				i += length;
 			}
 
-			ImGui::PopClipRect();
-
-			// allocate space
-			ImGui::SetCursorPos(uiPos);
-			ImGui::ItemSize(size);
+			score = std::max(score, contiguous.result());
 		}
-		// input box
-		else {
-			bool skipActiveCheck = false;
 
-			if (!(*state & 0b100)) {
-				skipActiveCheck = true;
-				ImGui::SetKeyboardFocusHere();
+		return score;
+	}
 
-				if (!ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-					*state |= 0b100;
-				}
+	// length of the folded extension at the end of a search key, directories have none
+	uint16_t typeKeyLength(std::string_view searchKey, bool isDirectory)
+	{
+		if (!isDirectory) {
+			if (auto dot = searchKey.rfind('.'); dot != std::string_view::npos && dot != 0) {
+				return static_cast<uint16_t>(std::min<size_t>(searchKey.size() - dot - 1, UINT16_MAX));
 			}
+		}
+		return 0;
+	}
 
-			if (ImGui::InputTextWithHint("##pathbox_input", "", &pathBuffer, ImGuiInputTextFlags_EnterReturnsTrue)) {
-				if (std::filesystem::exists(pathBuffer)) {
-					path = std::filesystem::u8path(pathBuffer);
-				}
+	/* SORTING */
+	// Digit runs become '0', their length and the digits without leading zeros, so a plain
+	// byte compare puts "frame2" before "frame10" and numbers before letters.
+	std::string naturalSortKey(std::string_view foldedText)
+	{
+		std::string ret;
+		ret.reserve(foldedText.size() + 8);
 
-				ret = true;
+		for (size_t i = 0; i < foldedText.size();) {
+			if (foldedText[i] < '0' || foldedText[i] > '9') {
+				ret.push_back(foldedText[i++]);
+				continue;
 			}
 
-			if (!skipActiveCheck && !ImGui::IsItemActive()) {
-				*state &= 0b010;
+			size_t end = i;
+			while (end < foldedText.size() && foldedText[end] >= '0' && foldedText[end] <= '9') {
+				end++;
 			}
+
+			size_t start = i;
+			while (start + 1 < end && foldedText[start] == '0') {
+				start++;
+			}
+
+			ret.push_back('0');
+			ret.push_back(static_cast<char>(std::min<size_t>(end - start, 0xFF)));
+			ret.append(foldedText.substr(start, end - start));
+			i = end;
 		}
 
 		return ret;
 	}
 
-	bool favoriteButton(const char* label, bool isFavorite)
+	// std::sort on equally sized chunks, one thread each, then the sorted runs are merged pairwise
+	// (also in parallel) until one run is left
+	template <typename Compare>
+	void parallelSort(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end, Compare compare, size_t threadCount)
 	{
-		ImGuiContext& g = *GImGui;
-		ImGuiWindow* window = g.CurrentWindow;
+		const size_t size = static_cast<size_t>(std::distance(begin, end));
+		threadCount = std::min<size_t>(threadCount, size / (PARALLEL_SORT_THRESHOLD / 4));
 
-		ImVec2 pos = window->DC.CursorPos;
-		bool ret = ImGui::InvisibleButton(label, ImVec2(computeGuiElementSize(GImGui->FontSize), computeGuiElementSize(GImGui->FontSize)));
-		
-		bool hovered = ImGui::IsItemHovered();
-		bool active = ImGui::IsItemActive();
+		if (threadCount <= 1) {
+			std::sort(begin, end, compare);
+			return;
+		}
 
-		float size = g.LastItemData.Rect.Max.x - g.LastItemData.Rect.Min.x;
+		std::vector<size_t> bounds;
+		for (size_t i = 0; i <= threadCount; i++) {
+			bounds.push_back(size * i / threadCount);
+		}
 
-		int numPoints = 5;
-		float innerRadius = size / 4;
-		float outerRadius = size / 2;
-		float angle = PI / numPoints;
-		ImVec2 center = ImVec2(pos.x + size / 2, pos.y + size / 2);
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < threadCount; i++) {
+			workers.emplace_back([=]() {
+				std::sort(begin + bounds[i], begin + bounds[i + 1], compare);
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
 
-		// fill
-		if (isFavorite || hovered || active) {
-			ImU32 fillColor = 0xff00ffff;// ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]);
-			
-			if (hovered || active) {
-				fillColor = ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]);
+		while (bounds.size() > 2) {
+			std::vector<size_t> merged;
+			workers.clear();
+
+			for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+				merged.push_back(bounds[i]);
+				if (i + 2 < bounds.size()) {
+					workers.emplace_back([=]() {
+						std::inplace_merge(begin + bounds[i], begin + bounds[i + 1], begin + bounds[i + 2], compare);
+					});
+				}
 			}
-				
-			// since there is no PathFillConcave, fill first the inner part, then the triangles
-			// inner
-			window->DrawList->PathClear();
-			for (int i = 1; i < numPoints * 2; i += 2) {
-				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin(i * angle), center.y - innerRadius * cos(i * angle)));
-			}
-			window->DrawList->PathFillConvex(fillColor);
-
-			// triangles
-			for (int i = 0; i < numPoints; i++) {
-				window->DrawList->PathClear();
-
-				int pIndex = i * 2;
-				window->DrawList->PathLineTo(ImVec2(center.x + outerRadius * sin(pIndex * angle), center.y - outerRadius * cos(pIndex * angle)));
-				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin((pIndex + 1) * angle), center.y - innerRadius * cos((pIndex + 1) * angle)));
-				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin((pIndex - 1) * angle), center.y - innerRadius * cos((pIndex - 1) * angle)));
+			merged.push_back(bounds.back());
 
-				window->DrawList->PathFillConvex(fillColor);
+			for (auto& worker : workers) {
+				worker.join();
 			}
+			bounds = std::move(merged);
 		}
+	}
 
-		// outline
-		window->DrawList->PathClear();
-		for (int i = 0; i < numPoints * 2; i++) {
-			float radius = i & 1 ? innerRadius : outerRadius;
-			window->DrawList->PathLineTo(ImVec2(center.x + radius * sin(i * angle), center.y - radius * cos(i * angle)));
+	/* RECURSIVE WALK */
+	struct DeviceInodeHash {
+		size_t operator()(const std::pair<uint64_t, uint64_t>& id) const noexcept
+		{
+			return std::hash<uint64_t>{}(id.first * 0x9E3779B97F4A7C15ULL ^ id.second);
 		}
-		window->DrawList->PathStroke(ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]), true, 2.0f);
+	};
 
-		return ret;
-	}
+	// one deque per worker, guarded by its own mutex
+	template <typename Item>
+	struct WalkQueue {
+		std::mutex mutex;
+		std::deque<Item> directories;
+	};
 
-	bool fileIcon(const char* label, bool isSelected, ImTextureID icon, ImVec2 size, bool hasPreview, int previewWidth, int previewHeight)
+	// Work-stealing walk: a worker pushes the subdirectories it finds to the back of its own deque and
+	// takes its next directory from there too (depth first), idle workers steal from the front of the
+	// others, where the oldest and usually biggest subtrees wait. Item is the directory's path or
+	// anything else visit needs to know about it. Returns once every directory was visited or running
+	// turns false.
+	template <typename Item, typename Visit>
+	void walkDirectories(std::vector<Item> roots, size_t threadCount, const std::atomic<bool>& running, Visit visit)
 	{
-		ImGuiStyle& style = ImGui::GetStyle();
-		ImGuiContext& g = *GImGui;
-		ImGuiWindow* window = g.CurrentWindow;
-
-		float windowSpace = ImGui::GetWindowPos().x + ImGui::GetWindowContentRegionMax().x;
-		ImVec2 pos = window->DC.CursorPos;
-		bool ret = false;
-
-		if (ImGui::InvisibleButton(label, size)) {
-			ret = true;
+		std::vector<WalkQueue<Item>> queues(threadCount);
+		std::atomic<size_t> pending{roots.size()}; // directories queued or being visited
+		std::atomic<size_t> queued{roots.size()}; // directories waiting in a deque
+		for (size_t i = 0; i < roots.size(); i++) {
+			queues[i % threadCount].directories.push_back(std::move(roots[i]));
 		}
 
-		bool hovered = ImGui::IsItemHovered();
-		bool active = ImGui::IsItemActive();
-		bool doubleClick = ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left);
-		if (doubleClick && hovered) {
-			ret = true;
-		}
+		// Idle workers wait here until there's something to steal or the walk is over. Whoever queues
+		// directories or finishes the last one notifies under idleMutex, so a worker can't miss it between
+		// checking and waiting. running is cleared without notifying, the timeout catches that.
+		std::mutex idleMutex;
+		std::condition_variable idle;
+		const auto wake = [&]() {
+			std::lock_guard<std::mutex> lock{idleMutex};
+			idle.notify_all();
+		};
 
-		float iconSize = size.y - g.FontSize * 2;
-		float iconPosX = pos.x + (size.x - iconSize) / 2.0f;
-		ImVec2 textSize = ImGui::CalcTextSize(label, 0, true, size.x);
+		const auto work = [&](size_t self) {
+			std::vector<Item> subdirectories;
 
-		
-		if (hovered || active || isSelected) {
-			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
-											g.LastItemData.Rect.Max, 
-											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : (isSelected ? ImGuiCol_Header : ImGuiCol_HeaderHovered)]));
-		}
+			while (running && pending > 0) {
+				Item directory;
+				bool found = false;
 
-		if (hasPreview) {
-			ImVec2 availSize = ImVec2(size.x, iconSize);
+				for (size_t i = 0; !found && i < threadCount; i++) {
+					auto& queue = queues[(self + i) % threadCount];
+					std::lock_guard<std::mutex> lock{queue.mutex};
 
-			float scale = std::min<float>(availSize.x / previewWidth, availSize.y / previewHeight);
-			availSize.x = previewWidth * scale;
-			availSize.y = previewHeight * scale;
+					if (!queue.directories.empty()) {
+						if (i == 0) {
+							directory = std::move(queue.directories.back());
+							queue.directories.pop_back();
+						} else {
+							directory = std::move(queue.directories.front());
+							queue.directories.pop_front();
+						}
+						queued--;
+						found = true;
+					}
+				}
 
-			float previewPosX = pos.x + (size.x - availSize.x) / 2.0f;
-			float previewPosY = pos.y + (iconSize - availSize.y) / 2.0f;
+				if (!found) {
+					std::unique_lock<std::mutex> lock{idleMutex};
+					idle.wait_for(lock, WALK_CANCEL_CHECK, [&]() { return queued > 0 || pending == 0 || !running; });
+					continue;
+				}
 
-			window->DrawList->AddImage(icon, ImVec2(previewPosX, previewPosY), ImVec2(previewPosX + availSize.x, previewPosY + availSize.y));
-		} else {
-			window->DrawList->AddImage(icon, ImVec2(iconPosX, pos.y), ImVec2(iconPosX + iconSize, pos.y + iconSize));
-		}
+				subdirectories.clear();
+				visit(self, directory, subdirectories);
 
-		window->DrawList->AddText(g.Font, 
-								  g.FontSize, 
-								  ImVec2(pos.x + (size.x-textSize.x) / 2.0f, pos.y + iconSize), 
-								  ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]), 
-								  label, 
-								  0, 
-								  size.x);
+				// count the children before this directory is done, so pending can't hit 0 early
+				pending += subdirectories.size();
+				if (!subdirectories.empty()) {
+					{
+						std::lock_guard<std::mutex> lock{queues[self].mutex};
+						for (auto& subdirectory : subdirectories) {
+							queues[self].directories.push_back(std::move(subdirectory));
+						}
+					}
+					queued += subdirectories.size();
+					wake();
+				}
+				if (--pending == 0) {
+					wake();
+				}
+			}
+		};
 
-		float lastButtomPos = ImGui::GetItemRectMax().x;
-		float thisButtonPos = lastButtomPos + style.ItemSpacing.x + size.x; // Expected position if next button was on same line
-		if (thisButtonPos < windowSpace) {
-			ImGui::SameLine();
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < threadCount; i++) {
+			workers.emplace_back(work, i);
 		}
+		work(0);
 
-		return ret;
+		for (auto& worker : workers) {
+			worker.join();
+		}
 	}
 
-	FileDialog::SmartSize::SmartSize(size_t s):
-		sizeInByte{s},
-		size{static_cast<float>(sizeInByte)},
-		unit{magic_enum::enum_name(SizeUnit::B)} 
+	/* LISTING INDEX */
+	// One file per directory, named after a hash of its canonical path. A file is only ever replaced as a whole
+	// by renaming a complete temporary file over it, so readers see the old or the new version and concurrent
+	// writers simply race to be last. Everything after the header is covered by the checksum.
+	//
+	// The header is followed by the key (padded to 8 bytes), sizes, datesModified and datesCreated as 64 bit
+	// integers, entryCount + 1 name offsets as 32 bit integers, the directory flags and the names, each
+	// followed by a '\0', so every array is naturally aligned in the mapping.
+	struct ListingIndexHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize; // catches a different layout of this struct too
+		uint64_t payloadSize;
+		uint64_t checksum;
+		int64_t dateModified; // DirectoryStamp of the directory when it was listed
+		uint64_t device;
+		uint64_t inode;
+		uint32_t keySize;
+		uint32_t entryCount;
+		uint64_t namesSize;
+	};
+
+	// FNV-1a over 8 byte words with an extra shift to carry high bits down, the tail byte by byte
+	uint64_t listingIndexChecksum(const char* data, size_t size)
 	{
-		if (size >= 1024) {
-			if (auto u = magic_enum::enum_cast<SizeUnit>(static_cast<uint8_t>(std::log(size) / std::log(1024.0f))); u) {
-				size = sizeInByte / std::pow(1024.0f, static_cast<float>(magic_enum::enum_integer(*u)));  // seems MSVC can't deduce std::pow to return float automatically
-				unit = magic_enum::enum_name(*u);
-			}
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(word));
+			hash = (hash ^ word) * 0x100000001B3ULL;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; i++) {
+			hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001B3ULL;
 		}
+		return hash;
 	}
 
-	FileDialog::FileData::FileData(const std::filesystem::path& p) 
+	inline size_t alignListingIndex(size_t size)
 	{
-		std::error_code ec;
-		path = p;
-		isDirectory = std::filesystem::is_directory(path, ec);
-		size = SmartSize{std::filesystem::file_size(path, ec)};
-
-		struct stat attr;
-		stat(path.u8string().c_str(), &attr);
-		dateModified = attr.st_ctime;
-
-		hasIconPreview = false;
-		iconPreview = nullptr;
-		iconPreviewData = nullptr;
-		iconPreviewHeight = 0;
-		iconPreviewWidth = 0;
+		return (size + 7) & ~size_t{7};
 	}
 
-	FileDialog::FileDialog():
-		m_isMultiselect{false},
-		m_isOpen{false},
-		m_type{DialogType::openFile},
-		m_calledOpenPopup{false},
-		m_zoom{MIN_ZOOM_LEVEL},
-		m_selectedFileItem{-1},
-		m_filterSelection{0},
-		m_previewLoaderRunning{false},
-		m_sortColumn{0},
-		m_sortDirection{ImGuiSortDirection_Ascending}
+	std::filesystem::path listingIndexFile(const std::filesystem::path& root, std::string_view key)
 	{
-		m_setDirectory(std::filesystem::current_path(), false);
-
-		// favorites are available on every OS
-		auto quickAccess = std::make_unique<FileTreeNode>("Quick Access");
-		quickAccess->read = true;
+		char name[24];
+		snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(listingIndexChecksum(key.data(), key.size())));
+		return root / name;
+	}
 
+	// read-only view of a whole file, data is nullptr if it couldn't be mapped
+	struct MappedFile {
+		MappedFile(const std::filesystem::path& path)
+		{
 #ifdef _WIN32
-		wchar_t username[UNLEN + 1] = { 0 };
-		DWORD username_len = UNLEN + 1;
-		GetUserNameW(username, &username_len);
-
-		std::wstring userPath = L"C:\\Users\\" + std::wstring(username) + L"\\";
-
-		// Quick Access / Bookmarks
-		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Desktop"));
-		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Documents"));
-		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Downloads"));
-		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Pictures"));
-		m_treeCache.emplace_back(std::move(quickAccess));
-
-		// OneDrive
-		auto oneDrive = std::make_unique<FileTreeNode>(_wgetenv(L"OneDriveConsumer"));
-		m_treeCache.emplace_back(std::move(oneDrive));
-
-		// This PC
-		auto thisPC = std::make_unique<FileTreeNode>("This PC");
-		thisPC->read = true;
-
-		if (std::filesystem::exists(userPath + L"3D Objects")) {
-			thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"3D Objects"));
-		}
-
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Desktop"));
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Documents"));
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Downloads"));
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Music"));
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Pictures"));
-		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Videos"));
-		DWORD d = GetLogicalDrives();
-
-		for (int i = 0; i < 26; i++) {
-			if (d & (1 << i)) {
-				thisPC->children.emplace_back(std::make_unique<FileTreeNode>(std::string(1, 'A' + i) + ":"));
+			file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			LARGE_INTEGER fileSize;
+			if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+				return;
+			}
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr) {
+				data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				size = data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
 			}
-		}
-		
-		m_treeCache.emplace_back(std::move(thisPC));
-#else
-		// Quick Access
-		struct passwd *pw;
-		uid_t uid;
-		uid = geteuid();
-		pw = getpwuid(uid);
-		if (pw) {
-
-#ifdef __APPLE__
-			std::string homePath = "/Users/" + std::string(pw->pw_name);
 #else
-			std::string homePath = "/home/" + std::string(pw->pw_name);
-#endif
-			
-			if (std::filesystem::exists(homePath)) {
-				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath));
+			const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				return;
 			}
-				
-			if (std::filesystem::exists(homePath + "/Desktop")) {
-				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Desktop"));
+			struct stat attr;
+			if (fstat(fd, &attr) == 0 && attr.st_size > 0) {
+				void* mapped = mmap(nullptr, static_cast<size_t>(attr.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapped != MAP_FAILED) {
+					data = static_cast<const char*>(mapped);
+					size = static_cast<size_t>(attr.st_size);
+				}
 			}
-				
-			if (std::filesystem::exists(homePath + "/Documents")) {
-				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Documents"));
+			::close(fd);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (data != nullptr) {
+				UnmapViewOfFile(data);
 			}
-				
-			if (std::filesystem::exists(homePath + "/Downloads")) {
-				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Downloads"));
+			if (mapping != nullptr) {
+				CloseHandle(mapping);
 			}
-				
-			if (std::filesystem::exists(homePath + "/Pictures")) {
-				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Pictures"));
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+#else
+			if (data != nullptr) {
+				munmap(const_cast<char*>(data), size);
 			}
+#endif
 		}
 
-		m_treeCache.emplace_back(std::move(quickAccess));
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
 
-		// This PC
-		auto thisPC = std::make_unique<FileTreeNode>("This PC");
-		thisPC->read = true;
-		for (const auto& entry : std::filesystem::directory_iterator("/")) {
-			if (std::filesystem::is_directory(entry)) {
-				thisPC->children.emplace_back(std::make_unique<FileTreeNode>(entry.path().u8string()));
-			}
-		}
-		m_treeCache.emplace_back(std::move(thisPC));
+		const char* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
 #endif
-	}
-
-	FileDialog::~FileDialog() {
-		m_clearIconPreview();
-		m_clearIcons();
-	}
+	};
 
-	bool FileDialog::save(const std::string& key, const std::string& title, const std::string& filter, const std::string& startingDir)
+	// writes a complete temporary file and renames it over file, false if either failed
+	bool replaceFile(const std::filesystem::path& file, const std::string& buffer)
 	{
-		if (!m_currentKey.empty())
-			return false;
+		static std::atomic<uint32_t> writeCount{0};
 
-		m_currentKey = key;
-		m_currentTitle = title + "###" + key;
-		m_isOpen = true;
-		m_calledOpenPopup = false;
-		m_result.clear();
-		m_inputTextbox = "";
-		m_selections.clear();
-		m_selectedFileItem = -1;
-		m_isMultiselect = false;
-		m_type = DialogType::saveFile;
+		// unique per process and write, so concurrent writers never share a temporary file
+#ifdef _WIN32
+		const auto processId = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+		const auto processId = static_cast<unsigned long>(getpid());
+#endif
+		auto temp = file;
+		temp += "." + std::to_string(processId) + "." + std::to_string(writeCount++) + ".tmp";
 
-		m_parseFilter(filter);
-		if (!startingDir.empty()) {
-			m_setDirectory(std::filesystem::u8path(startingDir), false);
-		} else {
-			m_setDirectory(m_currentDirectory, false); // refresh contents
+		bool written = false;
+		{
+			std::ofstream out{temp, std::ios::binary | std::ios::trunc};
+			written = out.write(buffer.data(), static_cast<std::streamsize>(buffer.size())) && out.flush();
+		}
+		std::error_code ec;
+		if (written) {
+			std::filesystem::rename(temp, file, ec);
+		}
+		if (!written || ec) {
+			std::filesystem::remove(temp, ec);
+			return false;
 		}
-
 		return true;
 	}
 
-	bool FileDialog::open(const std::string& key, const std::string& title, const std::string& filter, bool isMultiselect, const std::string& startingDir)
+	// runs on a file worker, also keeps the whole index under maxBytes
+	void writeListingIndexFile(std::filesystem::path root, size_t maxBytes, std::filesystem::path file, std::string buffer)
 	{
-		if (!m_currentKey.empty()) {
-			return false;
+		std::error_code ec;
+		std::filesystem::create_directories(root, ec);
+		if (!replaceFile(file, buffer)) {
+			return;
 		}
 
-		m_currentKey = key;
-		m_currentTitle = title + "###" + key;
-		m_isOpen = true;
-		m_calledOpenPopup = false;
-		m_result.clear();
-		m_inputTextbox = "";
-		m_selections.clear();
-		m_selectedFileItem = -1;
-		m_isMultiselect = isMultiselect;
-		m_type = filter.empty() ? DialogType::openDirectory : DialogType::openFile;
+		// drop the least recently used directories until the index fits
+		struct IndexFile {
+			std::filesystem::file_time_type time;
+			uintmax_t size;
+			std::filesystem::path path;
+		};
+		std::vector<IndexFile> files;
+		uintmax_t total = 0;
+		const auto now = std::filesystem::file_time_type::clock::now();
+
+		std::filesystem::directory_iterator it{root, ec};
+		for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			std::error_code entryEc;
+			const auto extension = it->path().extension();
+			const auto time = it->last_write_time(entryEc);
+			const auto size = it->file_size(entryEc);
+			if (entryEc) {
+				continue;
+			}
 
-		m_parseFilter(filter);
-		if (!startingDir.empty()) {
-			m_setDirectory(std::filesystem::u8path(startingDir), false);
-		} else {
-			m_setDirectory(m_currentDirectory, false); // refresh contents
+			if (extension == ".tmp" && now - time > LISTING_INDEX_STALE_TEMP) {
+				std::filesystem::remove(it->path(), entryEc);
+			} else if (extension == ".idx") {
+				files.push_back(IndexFile{time, size, it->path()});
+				total += size;
+			}
 		}
 
-		return true;
+		std::sort(files.begin(), files.end(), [](const IndexFile& left, const IndexFile& right) {
+			return left.time < right.time;
+		});
+		for (size_t i = 0; total > maxBytes && i < files.size(); i++) {
+			std::filesystem::remove(files[i].path, ec);
+			total -= files[i].size;
+		}
 	}
 
-	bool FileDialog::isDone(const std::string& key)
-	{
-		bool isMe = m_currentKey == key;
+	/* ICON CACHE FILE */
+	// Decoded theme icons of earlier runs in one file, replaced as a whole like a listing index file. It's only
+	// used while the theme has the name and stamp (see iconThemeStamp()) it was written for.
+	//
+	// The header is followed by the theme name (padded to 8 bytes), a 64 bit checksum per bitmap, iconCount +
+	// 2 * extensionCount + 1 string offsets as 32 bit integers and the strings, each followed by a '\0' and
+	// padded to 8 bytes as a whole: the icon keys, then pairs of folded extension and icon key. The header
+	// checksum covers all of that. The bitmaps come last, ICON_CACHE_BITMAP_SIZE bytes of RGBA each, and are
+	// only checked when one is read, so opening the file doesn't touch them.
+	struct IconCacheHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t payloadSize;
+		uint64_t checksum;
+		uint64_t themeStamp;
+		uint32_t cellSize; // width and height of every bitmap
+		uint32_t themeSize;
+		uint32_t iconCount;
+		uint32_t extensionCount;
+		uint64_t stringsSize;
+	};
+
+	// of a key or an extension and its key, summed up so the order entries are written in doesn't matter
+	uint64_t iconCacheEntryHash(std::string_view first, std::string_view second = {})
+	{
+		return listingIndexChecksum(first.data(), first.size()) * 31 + listingIndexChecksum(second.data(), second.size());
+	}
+
+	/* FILE SYSTEM ACCESS */
+	// Detached threads for calls that may block on a hung mount (NFS, SSHFS, FUSE, ...). Nobody ever joins
+	// them: a call stuck in the kernel keeps its worker, the next job gets a new one. Leaked on purpose, a
+	// stuck worker may outlive everything else. A mount gets no new calls while one is stuck there, so
+	// retrying it (or watching it) doesn't leave another blocked worker behind every time.
+	struct FileWorkers {
+		static FileWorkers& get()
+		{
+			static auto workers = new FileWorkers;
+			return *workers;
+		}
+
+		void submit(std::function<void()> job)
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			jobs.push_back(std::move(job));
+			if (jobs.size() > idle) {
+				std::thread(&FileWorkers::work, this).detach();
+			} else {
+				wake.notify_one();
+			}
+		}
+
+		void work()
+		{
+			std::unique_lock<std::mutex> lock{mutex};
+			while (true) {
+				idle++;
+				const bool hasJob = wake.wait_for(lock, FILE_WORKER_IDLE_TIMEOUT, [this]() { return !jobs.empty(); });
+				idle--;
+				if (!hasJob) {
+					return;
+				}
+
+				auto job = std::move(jobs.front());
+				jobs.pop_front();
+				lock.unlock();
+				job();
+				lock.lock();
+			}
+		}
+
+		bool isStuck(const std::string& mount)
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			return stuck.contains(mount);
+		}
+
+		void setStuck(const std::string& mount, bool isStuck)
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			if (isStuck) {
+				stuck[mount]++;
+			} else if (--stuck[mount] == 0) {
+				stuck.erase(mount);
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<std::function<void()>> jobs;
+		size_t idle = 0; // workers waiting for a job
+		std::unordered_map<std::string, size_t> stuck; // calls that ran out of time and haven't returned, by mount
+	};
+
+	// Runs call on a file worker and waits for it up to timeout, nullopt if it didn't return in time. It then
+	// finishes (or hangs) on its own, so call must own everything it touches. Until it does, later calls on
+	// the same mount (see mountOf()) return nullopt without running.
+	template <typename Call>
+	auto callWithTimeout(Call call, std::chrono::milliseconds timeout, std::string mount) -> std::optional<decltype(call())>
+	{
+		struct Shared {
+			std::mutex mutex;
+			std::condition_variable done;
+			std::optional<decltype(call())> result;
+			bool timedOut = false;
+		};
+
+		auto& workers = FileWorkers::get();
+		if (workers.isStuck(mount)) {
+			return std::nullopt;
+		}
+
+		const auto shared = std::make_shared<Shared>();
+		workers.submit([shared, call = std::move(call), mount]() mutable {
+			auto result = call();
+			std::lock_guard<std::mutex> lock{shared->mutex};
+			shared->result = std::move(result);
+			shared->done.notify_one();
+			if (shared->timedOut) {
+				FileWorkers::get().setStuck(mount, false);
+			}
+		});
+
+		std::unique_lock<std::mutex> lock{shared->mutex};
+		if (!shared->done.wait_for(lock, timeout, [&shared]() { return shared->result.has_value(); })) {
+			shared->timedOut = true;
+			workers.setStuck(mount, true);
+			return std::nullopt;
+		}
+		return std::move(shared->result);
+	}
+
+	// The mount point a path lives on (the drive or share on Windows), found without touching the path. When
+	// one call there doesn't answer, the whole mount is treated as not responding.
+	std::string mountOf(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		const auto absolute = std::filesystem::absolute(path, ec).lexically_normal();
+#if defined(__linux__) || defined(__APPLE__)
+		static std::mutex mutex;
+		static std::vector<std::string> mounts;
+		static std::chrono::steady_clock::time_point mountsRead;
+
+		std::lock_guard<std::mutex> lock{mutex};
+		const auto now = std::chrono::steady_clock::now();
+		if (mounts.empty() || now - mountsRead > MOUNT_TABLE_REFRESH) {
+			mounts.clear();
+			mountsRead = now;
+#ifdef __linux__
+			// procfs answers even when the mounts listed in it don't
+			std::ifstream table{"/proc/self/mounts"};
+			std::string device, mountPoint, rest;
+			while (table >> device >> mountPoint && std::getline(table, rest)) {
+				// spaces and the like are written as octal escapes
+				std::string decoded;
+				for (size_t i = 0; i < mountPoint.size(); i++) {
+					if (mountPoint[i] == '\\' && i + 3 < mountPoint.size() && isdigit(static_cast<unsigned char>(mountPoint[i + 1]))) {
+						decoded.push_back(static_cast<char>(std::stoi(mountPoint.substr(i + 1, 3), nullptr, 8)));
+						i += 3;
+					} else {
+						decoded.push_back(mountPoint[i]);
+					}
+				}
+				mounts.push_back(std::move(decoded));
+			}
+#else
+			// MNT_NOWAIT returns what the kernel has cached instead of asking every file system
+			struct statfs* entries = nullptr;
+			const int count = getmntinfo(&entries, MNT_NOWAIT);
+			for (int i = 0; i < count; i++) {
+				mounts.emplace_back(entries[i].f_mntonname);
+			}
+#endif
+		}
+
+		const std::string text = absolute.string();
+		std::string_view best = "/";
+		for (const auto& mount : mounts) {
+			if (mount.size() > best.size() && text.starts_with(mount) &&
+				(text.size() == mount.size() || text[mount.size()] == '/' || mount.back() == '/')) {
+				best = mount;
+			}
+		}
+		return std::string{best};
+#else
+		return absolute.root_path().u8string();
+#endif
+	}
+
+	// UTF-8 names of a directory's entries, empty if it can't be read
+	std::unordered_set<std::string> listNames(const std::filesystem::path& directory)
+	{
+		std::unordered_set<std::string> names;
+		std::error_code ec;
+		std::filesystem::directory_iterator it{directory, ec};
+		for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			names.insert(it->path().filename().u8string());
+		}
+		return names;
+	}
+
+#ifdef __linux__
+	/* ICON THEMES */
+	// a directory of a theme as described by its index.theme
+	struct IconThemeDirectory {
+		std::string name;
+		std::string type = "Threshold";
+		int size = 0, minSize = 0, maxSize = 0, threshold = 2, scale = 1;
+	};
+
+	struct IconThemeInfo {
+		std::vector<std::string> inherits;
+		std::vector<IconThemeDirectory> directories;
+	};
+
+	IconThemeInfo readIconThemeInfo(const std::filesystem::path& file)
+	{
+		const auto trim = [](std::string_view text) {
+			while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+				text.remove_prefix(1);
+			}
+			while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+				text.remove_suffix(1);
+			}
+			return text;
+		};
+		const auto split = [&trim](std::string_view list) {
+			std::vector<std::string> items;
+			while (!list.empty()) {
+				const auto comma = list.find(',');
+				const auto item = trim(list.substr(0, comma));
+				if (!item.empty()) {
+					items.emplace_back(item);
+				}
+				list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+			}
+			return items;
+		};
+
+		IconThemeInfo info;
+		std::unordered_map<std::string, size_t> directoryIndex;
+		std::ifstream in{file};
+		std::string line, section;
+		while (std::getline(in, line)) {
+			const auto text = trim(line);
+			if (text.empty() || text.front() == '#') {
+				continue;
+			}
+			if (text.front() == '[' && text.back() == ']') {
+				section = text.substr(1, text.size() - 2);
+				continue;
+			}
+
+			const auto equals = text.find('=');
+			if (equals == std::string_view::npos) {
+				continue;
+			}
+			const auto key = trim(text.substr(0, equals));
+			const auto value = trim(text.substr(equals + 1));
+
+			if (section == "Icon Theme") {
+				if (key == "Inherits") {
+					info.inherits = split(value);
+				} else if (key == "Directories" || key == "ScaledDirectories") {
+					for (auto& name : split(value)) {
+						if (directoryIndex.emplace(name, info.directories.size()).second) {
+							info.directories.push_back(IconThemeDirectory{name});
+						}
+					}
+				}
+			} else if (const auto found = directoryIndex.find(section); found != directoryIndex.end()) {
+				auto& directory = info.directories[found->second];
+				const int number = atoi(std::string{value}.c_str());
+				if (key == "Size") {
+					directory.size = number;
+				} else if (key == "MinSize") {
+					directory.minSize = number;
+				} else if (key == "MaxSize") {
+					directory.maxSize = number;
+				} else if (key == "Threshold") {
+					directory.threshold = number;
+				} else if (key == "Scale") {
+					directory.scale = number;
+				} else if (key == "Type") {
+					directory.type = value;
+				}
+			}
+		}
+
+		for (auto& directory : info.directories) {
+			directory.minSize = directory.minSize > 0 ? directory.minSize : directory.size;
+			directory.maxSize = directory.maxSize > 0 ? directory.maxSize : directory.size;
+		}
+		return info;
+	}
+
+	// 0 if the directory's icons fit size, otherwise how far off they are
+	int iconSizeDistance(const IconThemeDirectory& directory, int size)
+	{
+		if (directory.type == "Fixed") {
+			return std::abs(directory.size - size);
+		}
+		if (directory.type == "Scalable") {
+			return size < directory.minSize ? directory.minSize - size : std::max(0, size - directory.maxSize);
+		}
+		if (size < directory.size - directory.threshold) {
+			return directory.size - directory.threshold - size;
+		}
+		return std::max(0, size - directory.size - directory.threshold);
+	}
+
+	// ~/.icons, $XDG_DATA_HOME/icons and every $XDG_DATA_DIRS/icons, in lookup order
+	std::vector<std::filesystem::path> iconBaseDirectories()
+	{
+		std::vector<std::filesystem::path> directories;
+		directories.push_back(std::filesystem::path{g_get_home_dir()} / ".icons");
+		directories.push_back(std::filesystem::path{g_get_user_data_dir()} / "icons");
+		for (auto dataDirectories = g_get_system_data_dirs(); dataDirectories != nullptr && *dataDirectories != nullptr; dataDirectories++) {
+			directories.push_back(std::filesystem::path{*dataDirectories} / "icons");
+		}
+		return directories;
+	}
+
+	// the theme and the themes it inherits from, depth first as in the specification, hicolor last
+	std::vector<std::pair<std::string, IconThemeInfo>> readIconThemeChain(const std::string& theme, const std::vector<std::filesystem::path>& bases)
+	{
+		std::vector<std::pair<std::string, IconThemeInfo>> chain;
+		std::unordered_set<std::string> visited;
+		std::vector<std::string> pending{theme};
+		while (!pending.empty()) {
+			auto name = std::move(pending.back());
+			pending.pop_back();
+			if (name.empty() || !visited.insert(name).second) {
+				continue;
+			}
+
+			IconThemeInfo info;
+			for (const auto& base : bases) {
+				std::error_code ec;
+				if (std::filesystem::exists(base / name / "index.theme", ec)) {
+					info = readIconThemeInfo(base / name / "index.theme");
+					break;
+				}
+			}
+			for (auto parent = info.inherits.rbegin(); parent != info.inherits.rend(); ++parent) {
+				pending.push_back(*parent);
+			}
+			chain.emplace_back(std::move(name), std::move(info));
+			if (pending.empty() && !visited.contains(FALLBACK_ICON_THEME)) {
+				pending.push_back(FALLBACK_ICON_THEME);
+			}
+		}
+		return chain;
+	}
+
+	// Icon name to the file to load for every icon the theme, the themes it inherits from and hicolor provide.
+	// Within a theme the directory closest to size wins. Only PNGs are indexed, stb_image can't draw SVGs from
+	// scalable directories.
+	std::unordered_map<std::string, std::filesystem::path> buildIconThemeIndex(const std::string& theme, int size)
+	{
+		const auto bases = iconBaseDirectories();
+		const auto chain = readIconThemeChain(theme, bases);
+
+		std::unordered_map<std::string, std::filesystem::path> index;
+		for (const auto& [name, info] : chain) {
+			// best fit within this theme first, a parent only fills in names it doesn't have
+			std::unordered_map<std::string, std::pair<int, std::filesystem::path>> best;
+			for (const auto& directory : info.directories) {
+				if (directory.scale != 1) {
+					continue;
+				}
+				const int distance = iconSizeDistance(directory, size);
+
+				for (const auto& base : bases) {
+					std::error_code ec;
+					std::filesystem::directory_iterator it{base / name / directory.name, ec};
+					for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+						const auto& file = it->path();
+						if (file.extension() != ".png") {
+							continue;
+						}
+
+						auto [found, isNew] = best.try_emplace(file.stem().string(), distance, file);
+						if (!isNew && distance < found->second.first) {
+							found->second = {distance, file};
+						}
+					}
+				}
+			}
+
+			for (auto& [iconName, candidate] : best) {
+				index.try_emplace(iconName, std::move(candidate.second));
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::directory_iterator it{PIXMAPS_PATH, ec};
+		for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			if (it->path().extension() == ".png") {
+				index.try_emplace(it->path().stem().string(), it->path());
+			}
+		}
+
+		return index;
+	}
+
+	// Changes when an icon is added to or removed from a directory buildIconThemeIndex() reads, an index.theme
+	// is edited, or the MIME database that gives file types their icon names is updated. Directory mtimes are
+	// what GTK's icon caches go by as well.
+	uint64_t iconThemeStamp(const std::string& theme)
+	{
+		const auto bases = iconBaseDirectories();
+
+		std::vector<std::filesystem::path> paths;
+		for (const auto& [name, info] : readIconThemeChain(theme, bases)) {
+			for (const auto& base : bases) {
+				paths.push_back(base / name);
+				paths.push_back(base / name / "index.theme");
+				for (const auto& directory : info.directories) {
+					if (directory.scale == 1) {
+						paths.push_back(base / name / directory.name);
+					}
+				}
+			}
+		}
+		paths.push_back(PIXMAPS_PATH);
+		paths.push_back(std::filesystem::path{g_get_user_data_dir()} / "mime");
+		for (auto dataDirectories = g_get_system_data_dirs(); dataDirectories != nullptr && *dataDirectories != nullptr; dataDirectories++) {
+			paths.push_back(std::filesystem::path{*dataDirectories} / "mime");
+		}
+
+		// missing paths count too, one appearing changes the stamp
+		std::vector<int64_t> stamps;
+		for (const auto& path : paths) {
+			struct stat attr;
+			if (stat(path.c_str(), &attr) == 0) {
+				stamps.push_back(static_cast<int64_t>(attr.st_mtim.tv_sec) * 1000000000 + attr.st_mtim.tv_nsec);
+				stamps.push_back(static_cast<int64_t>(attr.st_ino));
+			} else {
+				stamps.push_back(-1);
+				stamps.push_back(0);
+			}
+		}
+		return listingIndexChecksum(reinterpret_cast<const char*>(stamps.data()), stamps.size() * sizeof(int64_t));
+	}
+#endif
+
+	/* UI CONTROLS */
+	bool folderNode(const char* label, ImTextureID icon, ImVec2 iconUv0, ImVec2 iconUv1, bool& clicked)
+	{
+		ImGuiContext& g = *GImGui;
+		ImGuiWindow* window = g.CurrentWindow;
+
+		clicked = false;
+
+		ImU32 id = window->GetID(label);
+		int opened = window->StateStorage.GetInt(id, 0);
+		ImVec2 pos = window->DC.CursorPos;
+		const bool is_mouse_x_over_arrow = (g.IO.MousePos.x >= pos.x && g.IO.MousePos.x < pos.x + g.FontSize);
+
+		if (ImGui::InvisibleButton(label, ImVec2(-FLT_MIN, g.FontSize + g.Style.FramePadding.y * 2)))
+		{
+			if (is_mouse_x_over_arrow) {
+				int* p_opened = window->StateStorage.GetIntRef(id, 0);
+				opened = *p_opened = !*p_opened;
+			} else {
+				clicked = true;
+			}
+		}
+
+		bool hovered = ImGui::IsItemHovered();
+		bool active = ImGui::IsItemActive();
+		bool doubleClick = ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left);
+
+		if (doubleClick && hovered) {
+			int* p_opened = window->StateStorage.GetIntRef(id, 0);
+			opened = *p_opened = !*p_opened;
+			clicked = false;
+		}
+
+		if (hovered || active) {
+			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
+											g.LastItemData.Rect.Max, 
+											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]));
+		}
+					
+		// Icon, text
+		float icon_posX = pos.x + g.FontSize + g.Style.FramePadding.y;
+		float text_posX = icon_posX + g.Style.FramePadding.y + computeIconSize(ImGui::GetFont()->FontSize);
+		ImGui::RenderArrow(window->DrawList, ImVec2(pos.x, pos.y+g.Style.FramePadding.y), ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[((hovered && is_mouse_x_over_arrow) || opened) ? ImGuiCol_Text : ImGuiCol_TextDisabled]), opened ? ImGuiDir_Down : ImGuiDir_Right);
+		window->DrawList->AddImage(icon, ImVec2(icon_posX, pos.y), ImVec2(icon_posX + computeIconSize(ImGui::GetFont()->FontSize), pos.y + computeIconSize(ImGui::GetFont()->FontSize)), iconUv0, iconUv1);
+		ImGui::RenderText(ImVec2(text_posX, pos.y + g.Style.FramePadding.y), label);
+		
+		if (opened) {
+			ImGui::TreePush(label);
+		}
+			
+		return opened != 0;
+	}
+
+	bool fileNode(const char* label, ImTextureID icon) {
+		ImGuiContext& g = *GImGui;
+		ImGuiWindow* window = g.CurrentWindow;
+
+		//ImU32 id = window->GetID(label);
+		ImVec2 pos = window->DC.CursorPos;
+		bool ret = ImGui::InvisibleButton(label, ImVec2(-FLT_MIN, g.FontSize + g.Style.FramePadding.y * 2));
+
+		bool hovered = ImGui::IsItemHovered();
+		bool active = ImGui::IsItemActive();
+
+		if (hovered || active) {
+			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
+											g.LastItemData.Rect.Max, 
+											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]));
+		}
+			
+		// Icon, text
+		window->DrawList->AddImage(icon, ImVec2(pos.x, pos.y), ImVec2(pos.x + computeIconSize(ImGui::GetFont()->FontSize), pos.y + computeIconSize(ImGui::GetFont()->FontSize)));
+		ImGui::RenderText(ImVec2(pos.x + g.Style.FramePadding.y + computeIconSize(ImGui::GetFont()->FontSize), pos.y + g.Style.FramePadding.y), label);
+		
+		return ret;
+	}
+
+	bool pathBox(const char* label, std::filesystem::path& path, std::string& pathBuffer, ImVec2 size_arg) {
+		ImGuiWindow* window = ImGui::GetCurrentWindow();
+
+		if (window->SkipItems) {
+			return false;
+		}
+
+		bool ret = false;
+		const ImGuiID id = window->GetID(label);
+		int* state = window->StateStorage.GetIntRef(id, 0);
+		
+		ImGui::SameLine();
+
+		ImGuiContext& g = *GImGui;
+		const ImGuiStyle& style = g.Style;
+		ImVec2 pos = window->DC.CursorPos;
+		ImVec2 uiPos = ImGui::GetCursorPos();
+		ImVec2 size = ImGui::CalcItemSize(size_arg, 200, computeGuiElementSize(GImGui->FontSize));
+		const ImRect bb(pos, pos + size);
+		
+		// buttons
+		if (!(*state & 0b001)) {
+			ImGui::PushClipRect(bb.Min, bb.Max, false);
+
+			// background
+			bool hovered = g.IO.MousePos.x >= bb.Min.x && g.IO.MousePos.x <= bb.Max.x &&
+				g.IO.MousePos.y >= bb.Min.y && g.IO.MousePos.y <= bb.Max.y;
+			bool clicked = hovered && ImGui::IsMouseReleased(ImGuiMouseButton_Left);
+			bool anyOtherHC = false; // are any other items hovered or clicked?
+			window->DrawList->AddRectFilled(pos, pos + size, ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[(*state & 0b10) ? ImGuiCol_FrameBgHovered : ImGuiCol_FrameBg]));
+
+			// fetch the buttons (so that we can throw some away if needed)
+			std::vector<std::string> btnList;
+			float totalWidth = 0.0f;
+			for (auto comp : path) {
+				std::string section = comp.u8string();
+
+				if (section.size() == 1 && (section[0] == '\\' || section[0] == '/')) {
+					continue;
+				}
+					
+				totalWidth += ImGui::CalcTextSize(section.c_str()).x + style.FramePadding.x * 2.0f + computeGuiElementSize(GImGui->FontSize);
+				btnList.push_back(section);
+			}
+			totalWidth -= computeGuiElementSize(GImGui->FontSize);
+
+			// UI buttons
+			ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, ImGui::GetStyle().ItemSpacing.y));
+			ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
+			bool isFirstElement = true;
+			for (size_t i = 0; i < btnList.size(); i++) {
+				if (totalWidth > size.x - 30 && i != btnList.size() - 1) { // trim some buttons if there's not enough space
+					float elSize = ImGui::CalcTextSize(btnList[i].c_str()).x + style.FramePadding.x * 2.0f + computeGuiElementSize(GImGui->FontSize);
+					totalWidth -= elSize;
+					continue;
+				}
+
+				ImGui::PushID(static_cast<int>(i));
+
+				if (!isFirstElement) {
+					ImGui::ArrowButtonEx("##dir_dropdown", ImGuiDir_Right, ImVec2(computeGuiElementSize(GImGui->FontSize), computeGuiElementSize(GImGui->FontSize)));
+					anyOtherHC |= ImGui::IsItemHovered() | ImGui::IsItemClicked();
+					ImGui::SameLine();
+				}
+
+				if (ImGui::Button(btnList[i].c_str(), ImVec2(0, computeGuiElementSize(GImGui->FontSize)))) {
+#ifdef _WIN32
+					std::string newPath = "";
+#else
+					std::string newPath = "/";
+#endif
+					for (size_t j = 0; j <= i; j++) {
+						newPath += btnList[j];
+#ifdef _WIN32
+						if (j != i) {
+							newPath += "\\";
+						}
+#else
+						if (j != i) {
+							newPath += "/";
+						}
+#endif
+					}
+					path = std::filesystem::u8path(newPath);
+					ret = true;
+				}
+
+				anyOtherHC |= ImGui::IsItemHovered() | ImGui::IsItemClicked();
+				ImGui::SameLine();
+				ImGui::PopID();
+
+				isFirstElement = false;
+			}
+			ImGui::PopStyleVar(2);
+
+
+			// click state
+			if (!anyOtherHC && clicked) {
+				pathBuffer = path.u8string();
+				*state |= 0b001;
+				*state &= 0b011; // remove SetKeyboardFocus flag
+			} else {
+				*state &= 0b110;
+			}
+
+			// hover state
+			if (!anyOtherHC && hovered && !clicked) {
+				*state |= 0b010;
+			} else {
+				*state &= 0b101;
+			}
+
+			ImGui::PopClipRect();
+
+			// allocate space
+			ImGui::SetCursorPos(uiPos);
+			ImGui::ItemSize(size);
+		}
+		// input box
+		else {
+			bool skipActiveCheck = false;
+
+			if (!(*state & 0b100)) {
+				skipActiveCheck = true;
+				ImGui::SetKeyboardFocusHere();
+
+				if (!ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+					*state |= 0b100;
+				}
+			}
+
+			if (ImGui::InputTextWithHint("##pathbox_input", "", &pathBuffer, ImGuiInputTextFlags_EnterReturnsTrue)) {
+				// the dialog shows the not responding notice if it's a hung mount
+				const auto typed = std::filesystem::u8path(pathBuffer);
+				if (callWithTimeout([typed]() { std::error_code ec; return std::filesystem::exists(typed, ec); }, FILE_STAT_TIMEOUT, mountOf(typed)).value_or(true)) {
+					path = typed;
+				}
+
+				ret = true;
+			}
+
+			if (!skipActiveCheck && !ImGui::IsItemActive()) {
+				*state &= 0b010;
+			}
+		}
+
+		return ret;
+	}
+
+	bool favoriteButton(const char* label, bool isFavorite)
+	{
+		ImGuiContext& g = *GImGui;
+		ImGuiWindow* window = g.CurrentWindow;
+
+		ImVec2 pos = window->DC.CursorPos;
+		bool ret = ImGui::InvisibleButton(label, ImVec2(computeGuiElementSize(GImGui->FontSize), computeGuiElementSize(GImGui->FontSize)));
+		
+		bool hovered = ImGui::IsItemHovered();
+		bool active = ImGui::IsItemActive();
+
+		float size = g.LastItemData.Rect.Max.x - g.LastItemData.Rect.Min.x;
+
+		int numPoints = 5;
+		float innerRadius = size / 4;
+		float outerRadius = size / 2;
+		float angle = PI / numPoints;
+		ImVec2 center = ImVec2(pos.x + size / 2, pos.y + size / 2);
+
+		// fill
+		if (isFavorite || hovered || active) {
+			ImU32 fillColor = 0xff00ffff;// ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]);
+			
+			if (hovered || active) {
+				fillColor = ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : ImGuiCol_HeaderHovered]);
+			}
+				
+			// since there is no PathFillConcave, fill first the inner part, then the triangles
+			// inner
+			window->DrawList->PathClear();
+			for (int i = 1; i < numPoints * 2; i += 2) {
+				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin(i * angle), center.y - innerRadius * cos(i * angle)));
+			}
+			window->DrawList->PathFillConvex(fillColor);
+
+			// triangles
+			for (int i = 0; i < numPoints; i++) {
+				window->DrawList->PathClear();
+
+				int pIndex = i * 2;
+				window->DrawList->PathLineTo(ImVec2(center.x + outerRadius * sin(pIndex * angle), center.y - outerRadius * cos(pIndex * angle)));
+				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin((pIndex + 1) * angle), center.y - innerRadius * cos((pIndex + 1) * angle)));
+				window->DrawList->PathLineTo(ImVec2(center.x + innerRadius * sin((pIndex - 1) * angle), center.y - innerRadius * cos((pIndex - 1) * angle)));
+
+				window->DrawList->PathFillConvex(fillColor);
+			}
+		}
+
+		// outline
+		window->DrawList->PathClear();
+		for (int i = 0; i < numPoints * 2; i++) {
+			float radius = i & 1 ? innerRadius : outerRadius;
+			window->DrawList->PathLineTo(ImVec2(center.x + radius * sin(i * angle), center.y - radius * cos(i * angle)));
+		}
+		window->DrawList->PathStroke(ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]), true, 2.0f);
+
+		return ret;
+	}
+
+	// one grid cell, the caller lays the cells out
+	bool fileIcon(const char* label, bool isSelected, ImTextureID icon, ImVec2 iconUv0, ImVec2 iconUv1, ImVec2 size, bool hasPreview, int previewWidth, int previewHeight)
+	{
+		ImGuiContext& g = *GImGui;
+		ImGuiWindow* window = g.CurrentWindow;
+
+		ImVec2 pos = window->DC.CursorPos;
+		bool ret = false;
+
+		if (ImGui::InvisibleButton(label, size)) {
+			ret = true;
+		}
+
+		bool hovered = ImGui::IsItemHovered();
+		bool active = ImGui::IsItemActive();
+		bool doubleClick = ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left);
+		if (doubleClick && hovered) {
+			ret = true;
+		}
+
+		float iconSize = size.y - g.FontSize * 2;
+		float iconPosX = pos.x + (size.x - iconSize) / 2.0f;
+		ImVec2 textSize = ImGui::CalcTextSize(label, 0, true, size.x);
+
+		
+		if (hovered || active || isSelected) {
+			window->DrawList->AddRectFilled(g.LastItemData.Rect.Min, 
+											g.LastItemData.Rect.Max, 
+											ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[active ? ImGuiCol_HeaderActive : (isSelected ? ImGuiCol_Header : ImGuiCol_HeaderHovered)]));
+		}
+
+		if (hasPreview) {
+			ImVec2 availSize = ImVec2(size.x, iconSize);
+
+			float scale = std::min<float>(availSize.x / previewWidth, availSize.y / previewHeight);
+			availSize.x = previewWidth * scale;
+			availSize.y = previewHeight * scale;
+
+			float previewPosX = pos.x + (size.x - availSize.x) / 2.0f;
+			float previewPosY = pos.y + (iconSize - availSize.y) / 2.0f;
+
+			window->DrawList->AddImage(icon, ImVec2(previewPosX, previewPosY), ImVec2(previewPosX + availSize.x, previewPosY + availSize.y));
+		} else {
+			window->DrawList->AddImage(icon, ImVec2(iconPosX, pos.y), ImVec2(iconPosX + iconSize, pos.y + iconSize), iconUv0, iconUv1);
+		}
+
+		window->DrawList->AddText(g.Font, 
+								  g.FontSize, 
+								  ImVec2(pos.x + (size.x-textSize.x) / 2.0f, pos.y + iconSize), 
+								  ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]), 
+								  label, 
+								  0, 
+								  size.x);
+
+		return ret;
+	}
+
+	FileDialog::SmartSize::SmartSize(size_t s):
+		sizeInByte{s},
+		size{static_cast<float>(sizeInByte)},
+		unit{magic_enum::enum_name(SizeUnit::B)} 
+	{
+		auto u = SizeUnit::B;
+		while (size >= 1024 && u != SizeUnit::TiB) {
+			size /= 1024;
+			u = static_cast<SizeUnit>(magic_enum::enum_integer(u) + 1);
+		}
+		unit = magic_enum::enum_name(u);
+	}
+
+#ifdef __linux__
+	// One statx for the type, size and dates, relative to dirFd (or AT_FDCWD). The headers having statx doesn't
+	// mean the kernel or a seccomp filter allows it, then fstatat does without the birth time.
+	bool statAt(int dirFd, const char* name, bool& isDirectory, size_t& size, time_t& dateModified, time_t& dateCreated)
+	{
+#ifdef STATX_BASIC_STATS
+		static std::atomic<bool> hasStatx{true};
+		if (hasStatx) {
+			struct statx attr;
+			if (statx(dirFd, name, AT_STATX_DONT_SYNC, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_BTIME, &attr) == 0) {
+				isDirectory = S_ISDIR(attr.stx_mode);
+				size = isDirectory ? 0 : static_cast<size_t>(attr.stx_size);
+				dateModified = attr.stx_mtime.tv_sec;
+				dateCreated = (attr.stx_mask & STATX_BTIME) ? attr.stx_btime.tv_sec : 0;
+				return true;
+			}
+			if (errno != ENOSYS && errno != EPERM) {
+				return false;
+			}
+			hasStatx = false;
+		}
+#endif
+
+		struct stat attr;
+		if (fstatat(dirFd, name, &attr, 0) != 0) {
+			return false;
+		}
+
+		isDirectory = S_ISDIR(attr.st_mode);
+		size = isDirectory ? 0 : static_cast<size_t>(attr.st_size);
+		dateModified = attr.st_mtime;
+		dateCreated = 0;
+		return true;
+	}
+#endif
+
+	// false if the path doesn't exist (anymore)
+	bool readAttributes(const std::filesystem::path& path, bool& isDirectory, size_t& size, time_t& dateModified, time_t& dateCreated)
+	{
+#ifdef _WIN32
+		struct _stat64 attr;
+		if (_wstat64(path.c_str(), &attr) != 0) {
+			return false;
+		}
+
+		std::error_code ec;
+		isDirectory = std::filesystem::is_directory(path, ec);
+		size = isDirectory ? 0 : static_cast<size_t>(attr.st_size);
+		dateModified = attr.st_mtime;
+		dateCreated = attr.st_ctime; // creation time on Windows
+#elif defined(__linux__)
+		// the same call as m_loadContent, so a watched entry compares equal to the loaded one
+		return statAt(AT_FDCWD, path.c_str(), isDirectory, size, dateModified, dateCreated);
+#else
+		// a single stat gives us the type, size and date
+		struct stat attr;
+		if (stat(path.c_str(), &attr) != 0) {
+			return false;
+		}
+
+		isDirectory = S_ISDIR(attr.st_mode);
+		size = isDirectory ? 0 : static_cast<size_t>(attr.st_size);
+		dateModified = attr.st_mtime;
+#ifdef __APPLE__
+		dateCreated = attr.st_birthtimespec.tv_sec;
+#else
+		dateCreated = 0;
+#endif
+#endif
+		return true;
+	}
+
+	void FileDialog::StringArena::push(std::string_view text)
+	{
+		data.append(text);
+		data.push_back('\0');
+		offsets.push_back(static_cast<uint32_t>(data.size()));
+	}
+
+	void FileDialog::StringArena::append(const StringArena& others)
+	{
+		const auto base = static_cast<uint32_t>(data.size());
+		data.append(others.data);
+		for (size_t i = 1; i < others.offsets.size(); i++) {
+			offsets.push_back(base + others.offsets[i]);
+		}
+	}
+
+	void FileDialog::StringArena::clear()
+	{
+		data.clear();
+		offsets.assign(1, 0);
+	}
+
+	void FileDialog::FilterMatcher::add(std::string_view pattern)
+	{
+		while (!pattern.empty() && (pattern.front() == ' ' || pattern.front() == '\t')) {
+			pattern.remove_prefix(1);
+		}
+		while (!pattern.empty() && (pattern.back() == ' ' || pattern.back() == '\t')) {
+			pattern.remove_suffix(1);
+		}
+		if (pattern.empty()) {
+			return;
+		}
+
+		if (!hasPatterns) {
+			hasPatterns = true;
+			matchAll = false;
+		}
+		if (pattern == "*" || pattern == ".*" || pattern == "*.*") {
+			matchAll = true;
+			return;
+		}
+
+		const std::string folded = foldCase(pattern);
+
+		// ".png": a plain extension, the same rule as std::filesystem::path::extension()
+		if (folded.size() > 1 && folded[0] == '.' && folded.find_first_of(".*?#[", 1) == std::string::npos) {
+			if (defaultExtension.empty()) {
+				defaultExtension = pattern;
+			}
+			extensions.insert(folded.substr(1));
+			return;
+		}
+
+		// anything else is a glob over the whole name, ".tar.gz" means "*.tar.gz"
+		Glob glob;
+		const auto addLiteral = [&glob](char c) {
+			if (glob.tokens.empty() || glob.tokens.back().kind != GlobToken::Kind::literal) {
+				glob.tokens.emplace_back(GlobToken::Kind::literal);
+			}
+			glob.tokens.back().literal.push_back(c);
+			glob.minLength++;
+		};
+
+		if (folded[0] == '.') {
+			glob.tokens.emplace_back(GlobToken::Kind::anyRun);
+		}
+		for (size_t i = 0; i < folded.size(); i++) {
+			const char c = folded[i];
+			if (c == '*') {
+				if (glob.tokens.empty() || glob.tokens.back().kind != GlobToken::Kind::anyRun) {
+					glob.tokens.emplace_back(GlobToken::Kind::anyRun);
+				}
+			} else if (c == '?') {
+				glob.tokens.emplace_back(GlobToken::Kind::anyCharacter);
+				glob.minLength++;
+			} else if (c == '#') {
+				glob.tokens.emplace_back(GlobToken::Kind::digit);
+				glob.minLength++;
+			} else if (c == '[' && folded.find(']', i + 2) != std::string::npos) {
+				GlobToken token{GlobToken::Kind::set};
+				size_t j = i + 1;
+				const bool negate = folded[j] == '!';
+				j += negate;
+
+				// a ']' right after the '[' is part of the set
+				do {
+					auto first = static_cast<unsigned char>(folded[j]), last = first;
+					if (j + 2 < folded.size() && folded[j + 1] == '-' && folded[j + 2] != ']') {
+						last = static_cast<unsigned char>(folded[j + 2]);
+						j += 2;
+					}
+					for (unsigned int b = first; b <= last; b++) {
+						token.set[b / 64] |= uint64_t{1} << (b % 64);
+					}
+					j++;
+				} while (j < folded.size() && folded[j] != ']');
+
+				if (negate) {
+					for (auto& bits : token.set) {
+						bits = ~bits;
+					}
+				}
+				glob.tokens.push_back(std::move(token));
+				glob.minLength++;
+				i = j;
+			} else {
+				addLiteral(c);
+			}
+		}
+
+		globs.push_back(std::move(glob));
+	}
+
+	bool FileDialog::FilterMatcher::matches(std::string_view name, std::string_view extension) const
+	{
+		if (matchAll || (!extension.empty() && extensions.contains(extension))) {
+			return true;
+		}
+
+		for (const auto& glob : globs) {
+			if (matchGlob(glob, name)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool FileDialog::FilterMatcher::matchGlob(const Glob& glob, std::string_view name)
+	{
+		const auto& tokens = glob.tokens;
+		if (name.size() < glob.minLength) {
+			return false;
+		}
+
+		// a literal at either end can be checked without walking the name
+		if (tokens.front().kind == GlobToken::Kind::literal && !name.starts_with(tokens.front().literal)) {
+			return false;
+		}
+		if (tokens.back().kind == GlobToken::Kind::literal && !name.ends_with(tokens.back().literal)) {
+			return false;
+		}
+
+		// greedy, going back to the last '*' on a mismatch, which is enough since every '*' matches anything
+		constexpr auto NO_RUN = SIZE_MAX;
+		size_t token = 0, at = 0, runToken = NO_RUN, runAt = 0;
+		while (token < tokens.size() || at < name.size()) {
+			if (token < tokens.size()) {
+				const auto& current = tokens[token];
+				const auto c = at < name.size() ? static_cast<unsigned char>(name[at]) : 0;
+				bool matched = false;
+
+				switch (current.kind) {
+				case GlobToken::Kind::anyRun:
+					runToken = token++;
+					runAt = at;
+					continue;
+				case GlobToken::Kind::literal:
+					if (name.substr(at).starts_with(current.literal)) {
+						at += current.literal.size();
+						matched = true;
+					}
+					break;
+				case GlobToken::Kind::anyCharacter:
+					if (at < name.size()) {
+						// a whole UTF-8 sequence
+						do {
+							at++;
+						} while (at < name.size() && (static_cast<unsigned char>(name[at]) & 0xC0) == 0x80);
+						matched = true;
+					}
+					break;
+				case GlobToken::Kind::digit:
+					if (at < name.size() && c >= '0' && c <= '9') {
+						at++;
+						matched = true;
+					}
+					break;
+				case GlobToken::Kind::set:
+					if (at < name.size() && (current.set[c / 64] >> (c % 64)) & 1) {
+						at++;
+						matched = true;
+					}
+					break;
+				}
+
+				if (matched) {
+					token++;
+					continue;
+				}
+			}
+
+			if (runToken == NO_RUN || runAt >= name.size()) {
+				return false;
+			}
+			token = runToken + 1;
+			at = ++runAt;
+		}
+
+		return true;
+	}
+
+	const char* FileDialog::Listing::filename(size_t i) const
+	{
+		const auto fullName = names[i];
+		if (!directory.empty()) {
+			return names.c_str(i);
+		}
+
+		// full paths only come from Quick Access and This PC
+#ifdef _WIN32
+		const auto separator = fullName.find_last_of("\\/");
+#else
+		const auto separator = fullName.rfind('/');
+#endif
+		if (separator == std::string_view::npos || separator + 1 == fullName.size()) {
+			return names.c_str(i); // drive or root
+		}
+		return names.c_str(i) + separator + 1;
+	}
+
+	std::filesystem::path FileDialog::Listing::path(size_t i) const
+	{
+		const auto u8name = std::filesystem::u8path(names[i]);
+		return directory.empty() ? u8name : directory / u8name;
+	}
+
+	void FileDialog::Listing::add(std::string_view name, bool isDir, size_t size, time_t dateModified, time_t dateCreated)
+	{
+		names.push(name);
+
+		const std::string searchKey = foldCase(filename(names.size() - 1));
+		searchKeys.push(searchKey);
+		sortKeys.push(naturalSortKey(searchKey));
+		searchMasks.push_back(characterMask(searchKey));
+
+		typeKeyLengths.push_back(typeKeyLength(searchKey, isDir));
+
+		directoryFlags.push_back(isDir);
+		sizes.push_back(isDir ? 0 : size);
+		datesModified.push_back(dateModified);
+		datesCreated.push_back(dateCreated);
+	}
+
+	void FileDialog::Listing::setDirectory(size_t i, bool isDir)
+	{
+		directoryFlags[i] = isDir;
+		typeKeyLengths[i] = typeKeyLength(searchKeys[i], isDir);
+	}
+
+	void FileDialog::Listing::add(const std::filesystem::path& p)
+	{
+		bool isDir = false;
+		size_t size = 0;
+		time_t dateModified = 0, dateCreated = 0;
+		readAttributes(p, isDir, size, dateModified, dateCreated);
+
+		add(directory.empty() ? p.u8string() : p.filename().u8string(), isDir, size, dateModified, dateCreated);
+	}
+
+	void FileDialog::Listing::append(const Listing& others)
+	{
+		names.append(others.names);
+		searchKeys.append(others.searchKeys);
+		sortKeys.append(others.sortKeys);
+		typeKeyLengths.insert(typeKeyLengths.end(), others.typeKeyLengths.begin(), others.typeKeyLengths.end());
+		directoryFlags.insert(directoryFlags.end(), others.directoryFlags.begin(), others.directoryFlags.end());
+		sizes.insert(sizes.end(), others.sizes.begin(), others.sizes.end());
+		datesModified.insert(datesModified.end(), others.datesModified.begin(), others.datesModified.end());
+		datesCreated.insert(datesCreated.end(), others.datesCreated.begin(), others.datesCreated.end());
+		searchMasks.insert(searchMasks.end(), others.searchMasks.begin(), others.searchMasks.end());
+	}
+
+	void FileDialog::Listing::clear()
+	{
+		names.clear();
+		searchKeys.clear();
+		sortKeys.clear();
+		typeKeyLengths.clear();
+		directoryFlags.clear();
+		sizes.clear();
+		datesModified.clear();
+		datesCreated.clear();
+		searchMasks.clear();
+	}
+
+	size_t FileDialog::Listing::memoryUsage() const
+	{
+		size_t bytes = sizeof(Listing) + directory.native().capacity() * sizeof(std::filesystem::path::value_type);
+		for (const auto* arena : {&names, &searchKeys, &sortKeys}) {
+			bytes += arena->data.capacity() + arena->offsets.capacity() * sizeof(uint32_t);
+		}
+
+		return bytes +
+			typeKeyLengths.capacity() * sizeof(uint16_t) +
+			directoryFlags.capacity() * sizeof(uint8_t) +
+			sizes.capacity() * sizeof(uint64_t) +
+			datesModified.capacity() * sizeof(time_t) +
+			datesCreated.capacity() * sizeof(time_t) +
+			searchMasks.capacity() * sizeof(uint64_t);
+	}
+
+	FileDialog::DirectoryStamp::DirectoryStamp(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		// no inode on Windows, the write time alone has to do
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		if (!ec) {
+			valid = true;
+			dateModified = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+		}
+#else
+		struct stat attr;
+		if (stat(path.c_str(), &attr) == 0 && S_ISDIR(attr.st_mode)) {
+			valid = true;
+#ifdef __APPLE__
+			dateModified = static_cast<int64_t>(attr.st_mtimespec.tv_sec) * 1000000000 + attr.st_mtimespec.tv_nsec;
+#else
+			dateModified = static_cast<int64_t>(attr.st_mtim.tv_sec) * 1000000000 + attr.st_mtim.tv_nsec;
+#endif
+			device = attr.st_dev;
+			inode = attr.st_ino;
+		}
+#endif
+	}
+
+	// Blocking calls made on the render thread go through here. A mount that let one of them run out of time
+	// fails every later call at once, until the user retries it from the content area.
+	template <typename Call>
+	auto FileDialog::m_callFileSystem(const std::filesystem::path& path, std::chrono::milliseconds timeout, Call call) -> std::optional<decltype(call())>
+	{
+		auto mount = mountOf(path);
+		if (m_unresponsiveMounts.contains(mount)) {
+			return std::nullopt;
+		}
+
+		auto result = callWithTimeout(std::move(call), timeout, mount);
+		if (!result) {
+			m_unresponsiveMounts.insert(std::move(mount));
+		}
+		return result;
+	}
+
+	bool FileDialog::m_exists(const std::filesystem::path& path)
+	{
+		return m_callFileSystem(path, FILE_STAT_TIMEOUT, [path]() {
+			std::error_code ec;
+			return std::filesystem::exists(path, ec);
+		}).value_or(false);
+	}
+
+	bool FileDialog::m_isResponsive(const std::filesystem::path& path) const
+	{
+		return m_unresponsiveMounts.empty() || !m_unresponsiveMounts.contains(mountOf(path));
+	}
+
+	FileDialog::FileDialog():
+		m_isMultiselect{false},
+		m_isOpen{false},
+		m_type{DialogType::openFile},
+		m_calledOpenPopup{false},
+		m_zoom{MIN_ZOOM_LEVEL},
+		m_selectionCount{0},
+		m_selectionAnchor{-1},
+		m_selectedFileItem{-1},
+		m_filterSelection{0},
+		m_iconCacheMaxIcons{DEFAULT_ICON_CACHE_MAX_ICONS},
+		m_iconCacheMaxBytes{DEFAULT_ICON_CACHE_MAX_BYTES},
+		m_iconCacheHits{0},
+		m_iconCacheMisses{0},
+		m_defaultIconTint{0},
+		m_sortSpecs{SortSpec{SortColumn::name, ImGuiSortDirection_Ascending}},
+		m_sortThreads{0},
+		m_contentLoading{false},
+		m_contentRevalidating{false},
+		m_contentProgress{0},
+		m_viewQueryMask{0},
+		m_searchSubfolders{false},
+		m_searchingSubfolders{false},
+		m_watchFd{-1},
+		m_folderSizesEnabled{false},
+		m_folderSizeCache{std::make_shared<FolderSizeCache>()},
+		m_folderSizesCount{0},
+		m_folderSizesDone{0},
+		m_listingCacheEntries{0},
+		m_listingCacheBytes{0},
+		m_listingCacheMaxEntries{DEFAULT_LISTING_CACHE_MAX_ENTRIES},
+		m_listingCacheMaxBytes{DEFAULT_LISTING_CACHE_MAX_BYTES},
+		m_listingIndexMaxBytes{0},
+		m_iconCacheFileMaxBytes{0}
+	{
+		m_setDirectory(std::filesystem::current_path(), false);
+
+		// favorites are available on every OS
+		auto quickAccess = std::make_unique<FileTreeNode>("Quick Access");
+		quickAccess->read = true;
+
+#ifdef _WIN32
+		wchar_t username[UNLEN + 1] = { 0 };
+		DWORD username_len = UNLEN + 1;
+		GetUserNameW(username, &username_len);
+
+		std::wstring userPath = L"C:\\Users\\" + std::wstring(username) + L"\\";
+
+		// Quick Access / Bookmarks
+		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Desktop"));
+		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Documents"));
+		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Downloads"));
+		quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Pictures"));
+		m_treeCache.emplace_back(std::move(quickAccess));
+
+		// OneDrive
+		auto oneDrive = std::make_unique<FileTreeNode>(_wgetenv(L"OneDriveConsumer"));
+		m_treeCache.emplace_back(std::move(oneDrive));
+
+		// This PC
+		auto thisPC = std::make_unique<FileTreeNode>("This PC");
+		thisPC->read = true;
+
+		if (m_exists(userPath + L"3D Objects")) {
+			thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"3D Objects"));
+		}
+
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Desktop"));
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Documents"));
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Downloads"));
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Music"));
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Pictures"));
+		thisPC->children.emplace_back(std::make_unique<FileTreeNode>(userPath + L"Videos"));
+		DWORD d = GetLogicalDrives();
+
+		for (int i = 0; i < 26; i++) {
+			if (d & (1 << i)) {
+				thisPC->children.emplace_back(std::make_unique<FileTreeNode>(std::string(1, 'A' + i) + ":"));
+			}
+		}
+		
+		m_treeCache.emplace_back(std::move(thisPC));
+#else
+		// Quick Access
+		struct passwd *pw;
+		uid_t uid;
+		uid = geteuid();
+		pw = getpwuid(uid);
+		if (pw) {
+
+#ifdef __APPLE__
+			std::string homePath = "/Users/" + std::string(pw->pw_name);
+#else
+			std::string homePath = "/home/" + std::string(pw->pw_name);
+#endif
+			
+			if (m_exists(homePath)) {
+				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath));
+			}
+				
+			if (m_exists(homePath + "/Desktop")) {
+				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Desktop"));
+			}
+				
+			if (m_exists(homePath + "/Documents")) {
+				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Documents"));
+			}
+				
+			if (m_exists(homePath + "/Downloads")) {
+				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Downloads"));
+			}
+				
+			if (m_exists(homePath + "/Pictures")) {
+				quickAccess->children.emplace_back(std::make_unique<FileTreeNode>(homePath + "/Pictures"));
+			}
+		}
+
+		m_treeCache.emplace_back(std::move(quickAccess));
+
+		// This PC
+		auto thisPC = std::make_unique<FileTreeNode>("This PC");
+		thisPC->read = true;
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator("/", ec)) {
+			if (entry.is_directory(ec)) { // the type read with the entry, mount points below aren't asked
+				thisPC->children.emplace_back(std::make_unique<FileTreeNode>(entry.path().u8string()));
+			}
+		}
+		m_treeCache.emplace_back(std::move(thisPC));
+#endif
+	}
+
+	FileDialog::~FileDialog() {
+		m_stopWatch();
+		m_stopContentLoader();
+		m_stopFolderSizes();
+		m_clearIconPreview();
+		m_clearIcons();
+		m_syncIconAtlas();
+	}
+
+	bool FileDialog::save(const std::string& key, const std::string& title, const std::string& filter, const std::string& startingDir)
+	{
+		if (!m_currentKey.empty())
+			return false;
+
+		m_currentKey = key;
+		m_currentTitle = title + "###" + key;
+		m_isOpen = true;
+		m_calledOpenPopup = false;
+		m_resultDirectory.clear();
+		m_resultNames.clear();
+		m_result.clear();
+		m_inputTextbox = "";
+		m_clearSelection();
+		m_isMultiselect = false;
+		m_type = DialogType::saveFile;
+
+		m_parseFilter(filter);
+		if (!startingDir.empty()) {
+			m_setDirectory(std::filesystem::u8path(startingDir), false);
+		} else {
+			m_setDirectory(m_currentDirectory, false); // refresh contents
+		}
+
+		return true;
+	}
+
+	bool FileDialog::open(const std::string& key, const std::string& title, const std::string& filter, bool isMultiselect, const std::string& startingDir)
+	{
+		if (!m_currentKey.empty()) {
+			return false;
+		}
+
+		m_currentKey = key;
+		m_currentTitle = title + "###" + key;
+		m_isOpen = true;
+		m_calledOpenPopup = false;
+		m_resultDirectory.clear();
+		m_resultNames.clear();
+		m_result.clear();
+		m_inputTextbox = "";
+		m_clearSelection();
+		m_isMultiselect = isMultiselect;
+		m_type = filter.empty() ? DialogType::openDirectory : DialogType::openFile;
+
+		m_parseFilter(filter);
+		if (!startingDir.empty()) {
+			m_setDirectory(std::filesystem::u8path(startingDir), false);
+		} else {
+			m_setDirectory(m_currentDirectory, false); // refresh contents
+		}
+
+		return true;
+	}
+
+	bool FileDialog::isDone(const std::string& key)
+	{
+		bool isMe = m_currentKey == key;
 
 		if (isMe && m_isOpen) {
 			if (!m_calledOpenPopup) {
@@ -732,691 +2315,2864 @@ namespace ifd {
 				m_calledOpenPopup = true;
 			}
 
-			if (ImGui::BeginPopupModal(m_currentTitle.c_str(), &m_isOpen, ImGuiWindowFlags_NoScrollbar)) {
-				m_renderFileDialog();
-				ImGui::EndPopup();
+			if (ImGui::BeginPopupModal(m_currentTitle.c_str(), &m_isOpen, ImGuiWindowFlags_NoScrollbar)) {
+				m_renderFileDialog();
+				ImGui::EndPopup();
+			} else {
+				m_isOpen = false;
+			}
+		}
+
+		return isMe && !m_isOpen;
+	}
+	void FileDialog::close()
+	{
+		m_currentKey.clear();
+		m_backHistory = std::stack<std::filesystem::path>();
+		m_forwardHistory = std::stack<std::filesystem::path>();
+		confirmationPopup = false;
+
+		m_stopWatch();
+		m_stopContentLoader();
+		m_stopFolderSizes();
+
+		for (auto& node : m_treeCache) {
+			for (auto& child : node->children) {
+				child->children.clear();
+				child->read = false;
+			}
+		}
+
+		// previews go, icons stay cached for the next dialog and are saved for the next run
+		m_clearIconPreview();
+		m_forgetIconPaths();
+		m_writeIconCacheFile();
+	}
+
+	void FileDialog::removeFavorite(const std::string& path)
+	{
+		auto itr = std::find(m_favorites.begin(), m_favorites.end(), m_currentDirectory.u8string());
+
+		if (itr != m_favorites.end())
+			m_favorites.erase(itr);
+
+		// remove from sidebar
+		for (auto& p : m_treeCache) {
+			if (p->path == "Quick Access") {
+				for (size_t i = 0; i < p->children.size(); i++)
+					if (p->children[i]->path == path) {
+						p->children.erase(p->children.begin() + i);
+						break;
+					}
+				break;
+			}
+		}
+	}
+
+	void FileDialog::addFavorite(const std::string& path)
+	{
+		if (std::count(m_favorites.begin(), m_favorites.end(), path) > 0)
+			return;
+
+		if (!m_exists(std::filesystem::u8path(path)))
+			return;
+
+		m_favorites.push_back(path);
+		
+		// add to sidebar
+		for (auto& p : m_treeCache) {
+			if (p->path == "Quick Access") {
+				p->children.emplace_back(std::make_unique<FileTreeNode>(path));
+				break;
+			}
+		}
+	}
+	
+	void FileDialog::setListingCacheLimits(size_t maxEntries, size_t maxBytes)
+	{
+		m_listingCacheMaxEntries = maxEntries;
+		m_listingCacheMaxBytes = maxBytes;
+		m_trimListingCache();
+	}
+
+	void FileDialog::setIconCacheLimits(size_t maxIcons, size_t maxBytes)
+	{
+		m_iconCacheMaxIcons = maxIcons;
+		m_iconCacheMaxBytes = maxBytes;
+		m_trimIconCache();
+	}
+
+	void FileDialog::setIconCacheFile(const std::string& path, size_t maxBytes)
+	{
+		m_iconCacheFilePath = std::filesystem::u8path(path);
+		m_iconCacheFileMaxBytes = maxBytes;
+#ifdef __linux__
+		// read with the theme otherwise
+		if (m_iconThemeIndex) {
+			m_openIconCacheFile(m_iconThemeIndex->theme);
+		}
+#endif
+	}
+
+	void FileDialog::invalidateListingCache(const std::string& path)
+	{
+		if (path.empty()) {
+			m_listingCache.clear();
+			m_listingCacheIndex.clear();
+			m_listingCacheEntries = 0;
+			m_listingCacheBytes = 0;
+			return;
+		}
+
+		std::error_code ec;
+		m_eraseListing(std::filesystem::weakly_canonical(std::filesystem::u8path(path), ec).u8string());
+	}
+
+	void FileDialog::setListingIndex(const std::string& path, size_t maxBytes)
+	{
+		m_listingIndexPath = std::filesystem::u8path(path);
+		m_listingIndexMaxBytes = maxBytes;
+	}
+
+	void FileDialog::setFolderSizes(bool enabled)
+	{
+		m_folderSizesEnabled = enabled;
+		if (enabled) {
+			m_startFolderSizes();
+			return;
+		}
+
+		m_stopFolderSizes();
+		m_contentFolderSizes.clear();
+		m_clearDisplayText();
+		if (std::any_of(m_sortSpecs.begin(), m_sortSpecs.end(), [](const SortSpec& spec) { return spec.column == SortColumn::size; })) {
+			m_sortContent();
+		}
+	}
+
+	const std::vector<std::filesystem::path>& FileDialog::getResults()
+	{
+		if (m_result.size() != m_resultNames.size()) {
+			m_result.clear();
+			m_result.reserve(m_resultNames.size());
+			for (size_t i = 0; i < m_resultNames.size(); i++) {
+				m_result.push_back(getResult(i));
+			}
+		}
+
+		return m_result;
+	}
+
+	void FileDialog::m_select(uint32_t index, bool isCtrlDown, bool isShiftDown)
+	{
+		bool multiselect = (isCtrlDown || isShiftDown) && m_isMultiselect;
+
+		if (multiselect && isShiftDown && m_selectionAnchor >= 0) {
+			// everything between the anchor and the clicked entry as currently displayed
+			const auto anchor = std::find(m_view.begin(), m_view.end(), static_cast<uint32_t>(m_selectionAnchor));
+			const auto clicked = std::find(m_view.begin(), m_view.end(), index);
+
+			if (anchor != m_view.end() && clicked != m_view.end()) {
+				if (!isCtrlDown) {
+					m_selectionBits.clear();
+					m_selectionCount = 0;
+				}
+
+				for (auto it = std::min(anchor, clicked); it <= std::max(anchor, clicked); ++it) {
+					if (m_isSelectable(*it)) {
+						m_setSelected(*it, true);
+					}
+				}
+
+				m_updateSelectionText();
+				return;
+			}
+		}
+
+		if (!multiselect) {
+			m_selectionBits.clear();
+			m_selectionCount = 0;
+			m_setSelected(index, true);
+		} else {
+			m_setSelected(index, !m_isSelected(index));
+		}
+
+		m_selectionAnchor = index;
+		m_updateSelectionText();
+	}
+
+	void FileDialog::m_selectAll()
+	{
+		if (!m_isMultiselect) {
+			return;
+		}
+
+		for (uint32_t index : m_view) {
+			if (m_isSelectable(index)) {
+				m_setSelected(index, true);
+			}
+		}
+
+		m_updateSelectionText();
+	}
+
+	bool FileDialog::m_isSelected(uint32_t index) const
+	{
+		return index / 64 < m_selectionBits.size() && (m_selectionBits[index / 64] >> (index % 64)) & 1;
+	}
+
+	bool FileDialog::m_isSelectable(uint32_t index) const
+	{
+		return !m_content.isDirectory(index) || m_type == DialogType::openDirectory;
+	}
+
+	void FileDialog::m_setSelected(uint32_t index, bool selected)
+	{
+		if (m_isSelected(index) == selected) {
+			return;
+		}
+
+		if (index / 64 >= m_selectionBits.size()) {
+			m_selectionBits.resize((m_content.size() + 63) / 64);
+		}
+
+		m_selectionBits[index / 64] ^= 1ULL << (index % 64);
+		if (selected) {
+			m_selectionCount++;
+		} else {
+			m_selectionCount--;
+		}
+	}
+
+	void FileDialog::m_updateSelectionText()
+	{
+		if (m_selectionCount == 0) {
+			m_inputTextbox.clear();
+			return;
+		}
+
+		// the box is only a summary, m_finalize reads the selection itself when there's more than one
+		std::string textboxVal;
+		size_t names = 0;
+		for (size_t word = 0; word < m_selectionBits.size() && names < std::min(m_selectionCount, MAX_SELECTION_TEXT_NAMES); word++) {
+			for (uint64_t bits = m_selectionBits[word]; bits != 0 && names < MAX_SELECTION_TEXT_NAMES; bits &= bits - 1) {
+				const char* filename = m_content.filename(word * 64 + std::countr_zero(bits));
+
+				if (m_selectionCount == 1) {
+					m_inputTextbox = filename;
+					return;
+				}
+
+				textboxVal += std::string("\"") + filename + "\", ";
+				names++;
+			}
+		}
+
+		if (m_selectionCount > names) {
+			textboxVal += "...";
+		} else {
+			textboxVal.resize(textboxVal.size() - 2);
+		}
+
+		m_inputTextbox = std::move(textboxVal);
+	}
+
+	void FileDialog::m_clearSelection()
+	{
+		m_selectedFileItem = -1;
+
+		if (m_type == DialogType::openDirectory || m_type == DialogType::openFile) {
+			m_inputTextbox = "";
+		}
+
+		m_selectionBits.clear();
+		m_selectionCount = 0;
+		m_selectionAnchor = -1;
+	}
+
+	bool FileDialog::m_selectionExists()
+	{
+		// a directory that doesn't answer has nothing to return
+		const auto directory = m_content.directory;
+		std::unordered_set<std::string> names;
+		if (!directory.empty()) {
+			const auto stamp = m_callFileSystem(directory, FILE_STAT_TIMEOUT, [directory]() { return DirectoryStamp{directory}; });
+			if (!stamp) {
+				return false;
+			}
+
+			// nothing was added or removed since the directory was listed, so every listed entry is still there
+			if (m_contentListingStamp.valid && *stamp == m_contentListingStamp) {
+				return true;
+			}
+
+			// otherwise read the directory once instead of checking each selection on its own
+			auto listed = m_callFileSystem(directory, FILE_LIST_TIMEOUT, [directory]() { return listNames(directory); });
+			if (!listed) {
+				return false;
+			}
+			names = std::move(*listed);
+		}
+
+		for (size_t word = 0; word < m_selectionBits.size(); word++) {
+			for (uint64_t bits = m_selectionBits[word]; bits != 0; bits &= bits - 1) {
+				const auto index = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+
+				if (directory.empty() ? !m_exists(m_content.path(index)) : !names.contains(std::string{m_content.name(index)})) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool FileDialog::m_finalize(const std::string& filename)
+	{
+		auto path = std::filesystem::u8path(filename);
+		bool hasResult = (!filename.empty() && m_type != DialogType::openDirectory) || m_type == DialogType::openDirectory;
+		
+		if (hasResult) {
+			if (m_type == DialogType::saveFile) {
+				// add the extension
+				if (m_filterSelection < m_filters.size() && !m_filters[m_filterSelection].defaultExtension.empty()) {
+					if (!path.has_extension()) {
+						path.replace_extension(std::filesystem::u8path(m_filters[m_filterSelection].defaultExtension));
+						m_inputTextbox = path.u8string();
+					}
+				}
+
+				// nothing is saved into a directory that doesn't answer, the content area offers to retry
+				const auto target = m_currentDirectory / path;
+				const auto exists = m_callFileSystem(target, FILE_STAT_TIMEOUT, [target]() { std::error_code ec; return std::filesystem::exists(target, ec); });
+				if (!exists) {
+					return false;
+				}
+
+				if (*exists && !confirmationPopup) {
+					// ask to confirm if overwrite 
+					// shouldn't call OpenPopup here because m_finalize may be called in a ID stack 
+					// level different to where we call BeginPopupModal
+					confirmationPopup = true;
+					return false;
+				}
+			}
+
+			if (!m_isMultiselect || m_selectionCount <= 1) {
+				// an absolute path replaces the directory when the result is read
+				m_resultDirectory = m_currentDirectory;
+				m_resultNames.push(path.u8string());
+
+				if (m_type == DialogType::openDirectory || m_type == DialogType::openFile) {
+					if (!m_exists(getResult(0))) {
+						m_resultNames.clear();
+						return false;
+					}
+				}
+			}
+			else {
+				if (!m_selectionExists()) {
+					return false;
+				}
+
+				m_resultDirectory = m_content.directory;
+				for (size_t word = 0; word < m_selectionBits.size(); word++) {
+					for (uint64_t bits = m_selectionBits[word]; bits != 0; bits &= bits - 1) {
+						m_resultNames.push(m_content.name(word * 64 + std::countr_zero(bits)));
+					}
+				}
+			}
+		}
+
+		m_isOpen = false;
+
+		return true;
+	}
+	void FileDialog::m_parseFilter(const std::string& filter)
+	{
+		m_filter = "";
+		m_filters.clear();
+		m_filterSelection = 0;
+
+		if (filter.empty()) {
+			return;
+		}
+
+		FilterMatcher matcher;
+
+		size_t lastSplit = 0, lastExt = 0;
+		bool inExtList = false;
+		for (size_t i = 0; i < filter.size(); i++) {
+			if (filter[i] == ',') {
+				if (!inExtList) {
+					lastSplit = i + 1;
+				} else {
+					matcher.add(std::string_view{filter}.substr(lastExt, i - lastExt));
+					lastExt = i + 1;
+				}
+			}
+			else if (filter[i] == '{') {
+				std::string filterName = filter.substr(lastSplit, i - lastSplit);
+				if (filterName == ".*") {
+					m_filter += std::string(std::string(__("All Files (*.*)\0")).c_str(), 16);
+					m_filters.emplace_back();
+				} else {
+					m_filter += std::string((filterName + "\0").c_str(), filterName.size() + 1);
+				}
+
+				inExtList = true;
+				lastExt = i + 1;
+			} else if (filter[i] == '}') {
+				matcher.add(std::string_view{filter}.substr(lastExt, i - lastExt));
+				m_filters.push_back(std::move(matcher));
+				matcher = FilterMatcher{};
+
+				inExtList = false;
+			}
+		}
+
+		if (lastSplit != 0) {
+			std::string filterName = filter.substr(lastSplit);
+			if (filterName == ".*") {
+				m_filter += std::string(std::string(__("All Files (*.*)\0")).c_str(), 16);
+				m_filters.emplace_back();
+			}
+			else {
+				m_filter += std::string((filterName + "\0").c_str(), filterName.size() + 1);
+			}
+		}
+	}
+
+#ifdef __linux__
+	std::filesystem::path FileDialog::m_locateIcon(IconThemeIndex& index, const std::string& iconName)
+	{
+		// the whole theme is indexed on the first lookup, later ones never touch the file system
+		std::call_once(index.built, [&index]() {
+			index.files = buildIconThemeIndex(index.theme.empty() ? FALLBACK_ICON_THEME : index.theme, DEFAULT_ICON_SIZE);
+		});
+
+		const auto icon = index.files.find(iconName);
+		return icon != index.files.end() ? icon->second : std::filesystem::path{};
+	}
+
+	void FileDialog::m_syncIconTheme()
+	{
+		// icons of the old theme go, a loader still using its index is stopped with them
+		auto theme = getIconTheme();
+		if (!m_iconThemeIndex || theme != m_iconThemeIndex->theme) {
+			m_clearIcons();
+			m_iconThemeIndex = std::make_shared<IconThemeIndex>();
+			m_iconThemeIndex->theme = std::move(theme);
+			m_openIconCacheFile(m_iconThemeIndex->theme);
+		}
+	}
+
+	void FileDialog::m_openIconCacheFile(const std::string& theme)
+	{
+		m_iconCacheFile = IconCacheFile{};
+		m_iconCacheFile.theme = theme;
+		if (m_iconCacheFilePath.empty()) {
+			return;
+		}
+
+		// the stamp reads the theme's directories, those and the file may be on a network home directory
+		const auto opened = m_callFileSystem(m_iconCacheFilePath, FILE_LIST_TIMEOUT, [file = m_iconCacheFilePath, theme]() {
+			return std::make_pair(iconThemeStamp(theme.empty() ? FALLBACK_ICON_THEME : theme), std::make_shared<MappedFile>(file));
+		});
+		if (!opened) {
+			return;
+		}
+		m_iconCacheFile.themeStamp = opened->first;
+		const auto& mapped = opened->second;
+		if (mapped->data == nullptr || mapped->size < sizeof(IconCacheHeader)) {
+			return;
+		}
+
+		IconCacheHeader header;
+		memcpy(&header, mapped->data, sizeof(header));
+		if (memcmp(header.magic, ICON_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != ICON_CACHE_VERSION ||
+			header.headerSize != sizeof(IconCacheHeader) || header.payloadSize != mapped->size - sizeof(header) ||
+			header.themeStamp != opened->first || header.cellSize != ICON_ATLAS_CELL_SIZE) {
+			return;
+		}
+
+		// everything but the bitmaps is checked now, an intact file can still lie about its sizes
+		const size_t count = header.iconCount;
+		const size_t stringCount = count + 2 * static_cast<size_t>(header.extensionCount);
+		const size_t themeSize = alignListingIndex(header.themeSize);
+		const size_t indexSize = themeSize + count * sizeof(uint64_t) + (stringCount + 1) * sizeof(uint32_t) + alignListingIndex(header.stringsSize);
+		if (header.stringsSize > header.payloadSize || indexSize > header.payloadSize || header.payloadSize - indexSize != count * ICON_CACHE_BITMAP_SIZE) {
+			return;
+		}
+
+		const char* payload = mapped->data + sizeof(header);
+		if (listingIndexChecksum(payload, indexSize) != header.checksum || std::string_view{payload, header.themeSize} != theme) {
+			return;
+		}
+
+		const char* checksums = payload + themeSize;
+		const char* offsets = checksums + count * sizeof(uint64_t);
+		const char* strings = offsets + (stringCount + 1) * sizeof(uint32_t);
+
+		std::vector<std::string_view> parsed;
+		uint32_t start = 0;
+		for (size_t i = 0; i <= stringCount; i++) {
+			uint32_t end;
+			memcpy(&end, offsets + i * sizeof(end), sizeof(end));
+			if (i == 0 ? end != 0 : end <= start || end > header.stringsSize || strings[end - 1] != '\0') {
+				return;
+			}
+			if (i != 0) {
+				parsed.emplace_back(strings + start, end - start - 1);
+			}
+			start = end;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			m_iconCacheFile.icons.emplace(parsed[i], static_cast<uint32_t>(i));
+			m_iconCacheFile.contents += iconCacheEntryHash(parsed[i]);
+		}
+		for (size_t i = count; i < stringCount; i += 2) {
+			m_iconCacheFile.extensionKeys.emplace(parsed[i], parsed[i + 1]);
+			m_iconCacheFile.contents += iconCacheEntryHash(parsed[i], parsed[i + 1]);
+		}
+		m_iconCacheFile.checksums = checksums;
+		m_iconCacheFile.bitmaps = reinterpret_cast<const uint8_t*>(payload + indexSize);
+		m_iconCacheFile.mapping = mapped;
+	}
+
+	void FileDialog::m_loadIcons(std::shared_ptr<IconLoader> loader, std::vector<IconRequest> requests, std::unordered_set<std::string> knownKeys, std::shared_ptr<IconThemeIndex> themeIndex)
+	{
+		struct FileIcon {
+			std::vector<std::string> themedNames;
+			std::filesystem::path file;
+		};
+
+		std::unordered_map<std::string, std::string> extensionKeys; // later files of a type aren't asked
+		std::unordered_set<std::string> unresponsiveMounts; // the rest of their files aren't asked either
+
+		for (size_t i = 0; loader->running && i < requests.size(); i++) {
+			LoadedIcon icon;
+			icon.path = std::move(requests[i].path);
+			icon.isFile = requests[i].isFile;
+
+			const auto& extension = requests[i].extension;
+			if (const auto key = extensionKeys.find(extension); !extension.empty() && key != extensionKeys.end()) {
+				icon.key = key->second;
+				icon.extension = extension;
+				icon.decodeSkipped = true;
+			} else {
+				// asked on a file worker, a hung mount keeps that instead of the loader
+				const auto path = std::filesystem::u8path(icon.path);
+				auto mount = mountOf(path);
+				std::optional<FileIcon> fileIcon;
+				if (!unresponsiveMounts.contains(mount)) {
+					fileIcon = callWithTimeout([path]() {
+						FileIcon result;
+						std::error_code ec;
+						// treat non-exists path as a director, such as "Quick access"
+						GFile* gFile = g_file_new_for_path(std::filesystem::exists(path, ec) ? path.c_str() : "/");
+						if (!G_IS_OBJECT(gFile)) {
+							return result;
+						}
+
+						const auto gFileInfo = g_file_query_info(gFile, G_FILE_ATTRIBUTE_STANDARD_ICON, G_FILE_QUERY_INFO_NONE, nullptr, nullptr);
+						const auto gIcon = G_IS_OBJECT(gFileInfo) ? g_file_info_get_icon(gFileInfo) : nullptr;
+						if (G_IS_THEMED_ICON(gIcon)) {
+							const auto names = g_themed_icon_get_names(G_THEMED_ICON(gIcon));
+							for (int i = 0; names[i] != NULL; i++) {
+								result.themedNames.emplace_back(names[i]);
+							}
+						} else if (G_IS_FILE_ICON(gIcon)) {
+							GFile *file_icon = g_file_icon_get_file(G_FILE_ICON(gIcon));
+							if (char* iconPath = g_file_get_path(file_icon)) {
+								result.file = iconPath;
+								g_free(iconPath);
+							}
+						}
+
+						if (G_IS_OBJECT(gFileInfo)) {
+							g_object_unref(gFileInfo);
+						}
+						g_object_unref(gFile);
+						return result;
+					}, ICON_QUERY_TIMEOUT, mount);
+
+					if (!fileIcon) {
+						unresponsiveMounts.insert(std::move(mount));
+					}
+				}
+				icon.timedOut = !fileIcon;
+
+				// the themed names (or the icon file) identify the icon, it's located and decoded once per key
+				if (fileIcon && !fileIcon->file.empty()) {
+					icon.key = "file:" + fileIcon->file.u8string();
+				} else if (fileIcon && !fileIcon->themedNames.empty()) {
+					icon.key = "theme:";
+					for (const auto& name : fileIcon->themedNames) {
+						icon.key += name;
+						icon.key += '\n';
+					}
+				}
+
+				icon.decodeSkipped = !icon.key.empty() && !knownKeys.insert(icon.key).second;
+				if (!icon.key.empty() && !icon.decodeSkipped) {
+					std::filesystem::path iconPath = fileIcon->file;
+					for (const auto& name : fileIcon->themedNames) {
+						if (iconPath.empty()) {
+							iconPath = m_locateIcon(*themeIndex, name);
+						}
+					}
+
+					int channel;
+					if (!iconPath.empty()) {
+						icon.data = stbi_load(iconPath.string().c_str(), &icon.width, &icon.height, &channel, STBI_rgb_alpha);
+					}
+				}
+
+				if (!icon.key.empty() && !extension.empty()) {
+					extensionKeys.emplace(extension, icon.key);
+					icon.extension = extension;
+				}
+			}
+			loader->progress++;
+
+			std::lock_guard<std::mutex> lock{loader->mutex};
+			if (!loader->running) {
+				stbi_image_free(icon.data); // stopped while decoding, nobody will pick it up
+				break;
+			}
+			loader->pending.push_back(std::move(icon));
+		}
+
+		loader->running = false;
+	}
+
+	void FileDialog::m_syncIcons()
+	{
+		if (m_iconLoader) {
+			const bool finished = !m_iconLoader->running; // before taking the icons, so none can come after them
+			std::vector<LoadedIcon> loaded;
+			{
+				std::lock_guard<std::mutex> lock{m_iconLoader->mutex};
+				loaded.swap(m_iconLoader->pending);
+			}
+
+			// only the upload is left for the render thread
+			for (auto& icon : loaded) {
+				if (icon.timedOut) {
+					m_unresponsiveMounts.insert(mountOf(std::filesystem::u8path(icon.path)));
+				}
+
+				// the loader skipped decoding an icon that has been evicted since, the next one decodes it
+				if (icon.decodeSkipped && !m_iconCacheIndex.contains(icon.key) && !m_iconCacheFile.icons.contains(icon.key) &&
+					!m_failedIconKeys.contains(icon.key)) {
+					m_iconRequests.push_back(IconRequest{std::move(icon.path), std::move(icon.extension), icon.isFile});
+					continue;
+				}
+
+				// a file that isn't there or isn't an image gets the default icon, and isn't read again
+				if (!icon.key.empty() && !icon.decodeSkipped && icon.data == nullptr) {
+					m_failedIconKeys.insert(icon.key);
+				}
+
+				const IconAtlas::Slot* slot = nullptr;
+				if (!icon.key.empty() && !m_failedIconKeys.contains(icon.key)) {
+					slot = m_iconSlot(icon.key, [this, &icon]() -> std::optional<IconAtlas::Slot> {
+						return icon.data != nullptr ? m_addIcon(icon.data, icon.width, icon.height, Format::RGBA) : std::nullopt;
+					});
+				}
+				if (icon.data != nullptr) {
+					stbi_image_free(icon.data);
+				}
+
+				if (slot == nullptr) {
+					slot = m_loadDefaultIcon(!icon.isFile);
+				} else if (!icon.extension.empty()) {
+					m_iconExtensionKeys.emplace(std::move(icon.extension), icon.key);
+				}
+				m_iconsRequested.erase(icon.path);
+				m_icons[std::move(icon.path)] = slot;
+			}
+
+			if (finished) {
+				m_iconLoader.reset();
+			}
+		}
+
+		// what was asked for while the last loader ran goes to the next one
+		if (!m_iconLoader && !m_iconRequests.empty()) {
+			// icons in the icon cache file don't need decoding either, nor do those that failed
+			std::unordered_set<std::string> knownKeys = m_failedIconKeys;
+			for (const auto& [key, entry] : m_iconCacheIndex) {
+				knownKeys.insert(key);
+			}
+			for (const auto& [key, bitmap] : m_iconCacheFile.icons) {
+				knownKeys.insert(key);
+			}
+
+			m_iconLoader = std::make_shared<IconLoader>();
+			std::thread(&FileDialog::m_loadIcons, m_iconLoader, std::move(m_iconRequests), std::move(knownKeys), m_iconThemeIndex).detach();
+			m_iconRequests.clear();
+		}
+	}
+
+	void FileDialog::m_stopIconLoader()
+	{
+		if (m_iconLoader) {
+			// under the lock, so the loader can't add icons after these are freed
+			std::lock_guard<std::mutex> lock{m_iconLoader->mutex};
+			m_iconLoader->running = false;
+			for (auto& icon : m_iconLoader->pending) {
+				stbi_image_free(icon.data);
+			}
+			m_iconLoader->pending.clear();
+		}
+		m_iconLoader.reset();
+		m_iconRequests.clear();
+		m_iconsRequested.clear();
+	}
+#endif
+
+	FileDialog::IconImage FileDialog::m_getIcon(const std::filesystem::path& path, bool isFile)
+	{
+		std::string pathU8 = path.u8string();
+
+		if (const auto icon = m_icons.find(pathU8); icon != m_icons.end()) {
+			return m_iconImage(icon->second);
+		}
+
+		// files of one type share an icon, only the first of them is asked for it
+		std::string extension = isFile ? foldCase(path.extension().u8string()) : std::string{};
+#ifdef _WIN32
+		// except for those that carry their own
+		if (extension == ".exe" || extension == ".ico" || extension == ".lnk" || extension == ".url" || extension == ".cur" || extension == ".ani" || extension == ".scr") {
+			extension.clear();
+		}
+#endif
+		if (!extension.empty()) {
+			// or was in an earlier run, then the icon cache file knows it
+			const auto key = m_iconExtensionKeys.find(extension);
+			const auto savedKey = m_iconCacheFile.extensionKeys.find(extension);
+			const std::string* iconKey = key != m_iconExtensionKeys.end() ? &key->second : savedKey != m_iconCacheFile.extensionKeys.end() ? &savedKey->second : nullptr;
+			if (iconKey != nullptr) {
+				if (const auto slot = m_findCachedIcon(*iconKey)) {
+					m_iconCacheHits++;
+					m_iconExtensionKeys.emplace(extension, *iconKey);
+					return m_iconImage(m_icons[std::move(pathU8)] = slot);
+				}
+			}
+		}
+
+		std::string key;
+		const IconAtlas::Slot* slot = nullptr;
+#ifdef _WIN32
+		DWORD attrs = 0;
+		UINT flags = SHGFI_LARGEICON;
+		if (!extension.empty()) {
+			flags |= SHGFI_USEFILEATTRIBUTES; // by type alone, the file isn't touched
+			attrs = FILE_ATTRIBUTE_NORMAL;
+		} else if (!m_exists(path)) { // a hung mount gets the folder icon without being asked again
+			flags |= SHGFI_USEFILEATTRIBUTES;
+			attrs = FILE_ATTRIBUTE_DIRECTORY;
+		}
+
+		std::wstring pathW = path.wstring();
+		for (int i = 0; i < pathW.size(); i++) {
+			if (pathW[i] == '/') {
+				pathW[i] = '\\';
+			}
+		}
+
+		// the index into the system image list identifies the icon, its bitmap is only read once per index
+		SHFILEINFOW fileInfo = { 0 };
+		if (SHGetFileInfoW(pathW.c_str(), attrs, &fileInfo, sizeof(SHFILEINFOW), flags | SHGFI_SYSICONINDEX) != 0) {
+			key = "system:" + std::to_string(fileInfo.iIcon);
+			slot = m_iconSlot(key, [&]() -> std::optional<IconAtlas::Slot> {
+				SHFILEINFOW iconFileInfo = { 0 };
+				SHGetFileInfoW(pathW.c_str(), attrs, &iconFileInfo, sizeof(SHFILEINFOW), flags | SHGFI_ICON);
+				if (iconFileInfo.hIcon == nullptr) {
+					return std::nullopt;
+				}
+
+				std::optional<IconAtlas::Slot> iconSlot;
+				ICONINFO iconInfo = { 0 };
+				if (GetIconInfo(iconFileInfo.hIcon, &iconInfo) && iconInfo.hbmColor != nullptr) {
+					DIBSECTION ds;
+					GetObject(iconInfo.hbmColor, sizeof(ds), &ds);
+					int byteSize = ds.dsBm.bmWidth * ds.dsBm.bmHeight * (ds.dsBm.bmBitsPixel / 8);
+
+					if (byteSize != 0) {
+						std::vector<uint8_t> bitmap(byteSize);
+						GetBitmapBits(iconInfo.hbmColor, byteSize, bitmap.data());
+						iconSlot = m_addIcon(bitmap.data(), ds.dsBm.bmWidth, ds.dsBm.bmHeight, Format::BGRA);
+					}
+				}
+
+				if (iconInfo.hbmColor != nullptr) {
+					DeleteObject(iconInfo.hbmColor);
+				}
+				if (iconInfo.hbmMask != nullptr) {
+					DeleteObject(iconInfo.hbmMask);
+				}
+				DestroyIcon(iconFileInfo.hIcon);
+				return iconSlot;
+			});
+		}
+#elif defined(__linux__)
+		// looked up and decoded by m_loadIcons, a default icon stands in until m_syncIcons has it
+		if (!m_isResponsive(path)) {
+			return m_iconImage(m_icons[std::move(pathU8)] = m_loadDefaultIcon(!isFile));
+		}
+		if (m_iconsRequested.insert(pathU8).second) {
+			m_iconRequests.push_back(IconRequest{std::move(pathU8), std::move(extension), isFile});
+		}
+		return m_iconImage(m_loadDefaultIcon(!isFile));
+#elif defined(__APPLE__)
+		const auto toSlot = [this](NSImage* icon) -> std::optional<IconAtlas::Slot> {
+			if (icon == nullptr) {
+				return std::nullopt;
+			}
+
+			CGImageRef cgImage = [icon CGImageForProposedRect:nullptr context:nullptr hints:nullptr];
+			CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+			auto width = CGImageGetWidth(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL;
+			auto height = CGImageGetHeight(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL;
+			// use alloc to ensure all initialized to zero
+			std::unique_ptr<uint8_t> rawData{reinterpret_cast<uint8_t*>(calloc(width * height * DEFAULT_ICON_CHANNELS, sizeof(uint8_t)))};
+			CGContextRef bitmapContext = CGBitmapContextCreate(rawData.get(), 
+															   width, 
+															   height, 
+															   CGImageGetBitsPerComponent(cgImage), 
+															   CGImageGetBytesPerRow(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL, 
+															   colorSpace, 
+															   CGImageGetAlphaInfo(cgImage));
+			
+			if (bitmapContext == nullptr) {
+				CGImageRelease(cgImage);
+				CGColorSpaceRelease(colorSpace);
+				return std::nullopt;
+			}
+
+			CGContextScaleCTM(bitmapContext, APPLE_ICON_DEFAULT_SCALE_LEVEL, APPLE_ICON_DEFAULT_SCALE_LEVEL);
+			CGContextDrawImage(bitmapContext, CGRectMake(0, 0, width / APPLE_ICON_DEFAULT_SCALE_LEVEL, height / APPLE_ICON_DEFAULT_SCALE_LEVEL), cgImage);
+
+			const auto iconSlot = m_addIcon(reinterpret_cast<const uint8_t*>(rawData.get()), width, height, Format::RGBA);
+
+			CGImageRelease(cgImage);
+			CGColorSpaceRelease(colorSpace);
+			CGContextRelease(bitmapContext);
+			return iconSlot;
+		};
+
+		// by type when there's an extension, the file's own icon otherwise (applications, custom folder icons)
+		if (!extension.empty()) {
+			key = "type:" + extension;
+			slot = m_iconSlot(key, [&]() {
+				return toSlot([[NSWorkspace sharedWorkspace] iconForFileType:[NSString stringWithUTF8String:extension.c_str() + 1]]);
+			});
+		} else if (m_exists(path)) {
+			key = "path:" + pathU8;
+			slot = m_iconSlot(key, [&]() {
+				return toSlot([[NSWorkspace sharedWorkspace] iconForFile:[NSString stringWithUTF8String:pathU8.c_str()]]);
+			});
+		} else {
+			key = "path:/bin";
+			slot = m_iconSlot(key, [&]() {
+				return toSlot([[NSWorkspace sharedWorkspace] iconForFile:@"/bin"]);
+			});
+		}
+#endif
+
+		if (slot == nullptr) {
+			slot = m_loadDefaultIcon(!isFile);
+		} else if (!extension.empty()) {
+			m_iconExtensionKeys.emplace(std::move(extension), std::move(key));
+		}
+		return m_iconImage(m_icons[std::move(pathU8)] = slot);
+	}
+
+	std::optional<FileDialog::IconAtlas::Slot> FileDialog::IconAtlas::allocate(size_t pageCount)
+	{
+		const auto count = static_cast<uint32_t>(std::min(pageCount, pages.size()));
+		const auto take = [](Page& page, uint32_t cell) {
+			page.usedCells++;
+			return cell;
+		};
+
+		// a hole first, then a cell that was never used, then a taller page, then a new one
+		for (uint32_t i = 0; i < count; i++) {
+			if (!pages[i].freeCells.empty()) {
+				const auto cell = pages[i].freeCells.back();
+				pages[i].freeCells.pop_back();
+				return Slot{i, take(pages[i], cell)};
+			}
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			if (pages[i].nextCell < pages[i].rows * ICON_ATLAS_COLUMNS) {
+				return Slot{i, take(pages[i], pages[i].nextCell++)};
+			}
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			auto& page = pages[i];
+			if (page.rows < ICON_ATLAS_MAX_ROWS) {
+				page.rows = std::min(page.rows * 2, ICON_ATLAS_MAX_ROWS);
+				page.pixels.resize(static_cast<size_t>(page.rows) * ICON_ATLAS_CELL_STRIDE * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS);
+				return Slot{i, take(page, page.nextCell++)};
+			}
+		}
+		if (pageCount <= pages.size()) {
+			return std::nullopt;
+		}
+
+		auto& page = pages.emplace_back();
+		page.rows = ICON_ATLAS_INITIAL_ROWS;
+		page.pixels.resize(static_cast<size_t>(page.rows) * ICON_ATLAS_CELL_STRIDE * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS);
+		return Slot{count, take(page, page.nextCell++)};
+	}
+
+	void FileDialog::IconAtlas::write(Slot slot, const uint8_t* data, int width, int height, Format format)
+	{
+		const int channels = format == Format::RGB ? 3 : 4;
+		const int red = format == Format::BGRA ? 2 : 0;
+		const int blue = format == Format::BGRA ? 0 : 2;
+		uint8_t* cell = cellPixels(slot) + (ICON_ATLAS_PAGE_WIDTH + 1) * DEFAULT_ICON_CHANNELS;
+
+		// the same as averaging below at this size, without a division per channel (icon cache file bitmaps)
+		if (width == ICON_ATLAS_CELL_SIZE && height == ICON_ATLAS_CELL_SIZE && format == Format::RGBA) {
+			for (int y = 0; y < ICON_ATLAS_CELL_SIZE; y++) {
+				uint8_t* out = cell + static_cast<size_t>(y) * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS;
+				memcpy(out, data + static_cast<size_t>(y) * ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS, ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS);
+				for (int x = 0; x < ICON_ATLAS_CELL_SIZE; x++, out += DEFAULT_ICON_CHANNELS) {
+					if (out[3] == 0) {
+						memset(out, 0, DEFAULT_ICON_CHANNELS);
+					}
+				}
+			}
+
+			fillCellBorder(slot);
+			pages[slot.page].dirty = true;
+			return;
+		}
+
+		// every cell pixel averages the source pixels it covers (a single one when enlarging), weighted
+		// by alpha so transparent pixels don't darken the edges
+		for (int y = 0; y < ICON_ATLAS_CELL_SIZE; y++) {
+			const int top = y * height / ICON_ATLAS_CELL_SIZE;
+			const int bottom = std::max(top + 1, (y + 1) * height / ICON_ATLAS_CELL_SIZE);
+			uint8_t* out = cell + static_cast<size_t>(y) * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS;
+
+			for (int x = 0; x < ICON_ATLAS_CELL_SIZE; x++, out += DEFAULT_ICON_CHANNELS) {
+				const int left = x * width / ICON_ATLAS_CELL_SIZE;
+				const int right = std::max(left + 1, (x + 1) * width / ICON_ATLAS_CELL_SIZE);
+
+				uint64_t r = 0, g = 0, b = 0, a = 0;
+				for (int sy = top; sy < bottom; sy++) {
+					const uint8_t* in = data + (static_cast<size_t>(sy) * width + left) * channels;
+					for (int sx = left; sx < right; sx++, in += channels) {
+						const uint32_t alpha = channels == 4 ? in[3] : 255;
+						r += in[red] * alpha;
+						g += in[1] * alpha;
+						b += in[blue] * alpha;
+						a += alpha;
+					}
+				}
+
+				const uint64_t covered = static_cast<uint64_t>(bottom - top) * (right - left);
+				out[0] = a ? static_cast<uint8_t>(r / a) : 0;
+				out[1] = a ? static_cast<uint8_t>(g / a) : 0;
+				out[2] = a ? static_cast<uint8_t>(b / a) : 0;
+				out[3] = static_cast<uint8_t>(a / covered);
+			}
+		}
+
+		fillCellBorder(slot);
+		pages[slot.page].dirty = true;
+	}
+
+	void FileDialog::IconAtlas::copy(Slot from, Slot to)
+	{
+		const uint8_t* in = cellPixels(from);
+		uint8_t* out = cellPixels(to);
+		for (int y = 0; y < ICON_ATLAS_CELL_STRIDE; y++) {
+			memcpy(out + static_cast<size_t>(y) * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS, in + static_cast<size_t>(y) * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS, ICON_ATLAS_CELL_STRIDE * DEFAULT_ICON_CHANNELS);
+		}
+		pages[to.page].dirty = true;
+	}
+
+	void FileDialog::IconAtlas::release(Slot slot)
+	{
+		uint8_t* out = cellPixels(slot);
+		for (int y = 0; y < ICON_ATLAS_CELL_STRIDE; y++) {
+			memset(out + static_cast<size_t>(y) * ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS, 0, ICON_ATLAS_CELL_STRIDE * DEFAULT_ICON_CHANNELS);
+		}
+
+		auto& page = pages[slot.page];
+		page.usedCells--;
+		page.releasedCells.push_back(slot.cell);
+		page.dirty = true;
+	}
+
+	void FileDialog::IconAtlas::fillCellBorder(Slot slot)
+	{
+		constexpr size_t pitch = ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS;
+		uint8_t* block = cellPixels(slot);
+
+		// the outermost rows and columns of the icon are repeated around it
+		memcpy(block + DEFAULT_ICON_CHANNELS, block + pitch + DEFAULT_ICON_CHANNELS, ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS);
+		memcpy(block + (ICON_ATLAS_CELL_SIZE + 1) * pitch + DEFAULT_ICON_CHANNELS, block + ICON_ATLAS_CELL_SIZE * pitch + DEFAULT_ICON_CHANNELS, ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS);
+		for (int y = 0; y < ICON_ATLAS_CELL_STRIDE; y++) {
+			uint8_t* row = block + y * pitch;
+			memcpy(row, row + DEFAULT_ICON_CHANNELS, DEFAULT_ICON_CHANNELS);
+			memcpy(row + (ICON_ATLAS_CELL_SIZE + 1) * DEFAULT_ICON_CHANNELS, row + ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS, DEFAULT_ICON_CHANNELS);
+		}
+	}
+
+	uint8_t* FileDialog::IconAtlas::cellPixels(Slot slot)
+	{
+		// top left of the border around the cell
+		const size_t x = (slot.cell % ICON_ATLAS_COLUMNS) * ICON_ATLAS_CELL_STRIDE;
+		const size_t y = (slot.cell / ICON_ATLAS_COLUMNS) * ICON_ATLAS_CELL_STRIDE;
+		return pages[slot.page].pixels.data() + (y * ICON_ATLAS_PAGE_WIDTH + x) * DEFAULT_ICON_CHANNELS;
+	}
+
+	const FileDialog::IconAtlas::Slot* FileDialog::m_iconSlot(const std::string& key, const std::function<std::optional<IconAtlas::Slot>()>& load)
+	{
+		if (const auto slot = m_findCachedIcon(key)) {
+			m_iconCacheHits++;
+			return slot;
+		}
+		m_iconCacheMisses++;
+
+		// a key that failed to load isn't stored, the caller falls back to a default icon
+		const auto slot = load();
+		return slot ? m_storeIcon(key, *slot) : nullptr;
+	}
+
+	const FileDialog::IconAtlas::Slot* FileDialog::m_findIcon(const std::string& key)
+	{
+		auto it = m_iconCacheIndex.find(key);
+		if (it == m_iconCacheIndex.end()) {
+			return nullptr;
+		}
+
+		m_iconCache.splice(m_iconCache.begin(), m_iconCache, it->second);
+		return &it->second->slot;
+	}
+
+	const FileDialog::IconAtlas::Slot* FileDialog::m_findCachedIcon(const std::string& key)
+	{
+		if (const auto slot = m_findIcon(key)) {
+			return slot;
+		}
+		const auto slot = m_readIconCacheFile(key);
+		return slot ? m_storeIcon(key, *slot) : nullptr;
+	}
+
+	const FileDialog::IconAtlas::Slot* FileDialog::m_storeIcon(const std::string& key, IconAtlas::Slot slot)
+	{
+		// trimmed by the next m_syncIconAtlas, nothing drawn during this frame goes away under it
+		m_iconCache.push_front(IconCacheEntry{key, slot});
+		m_iconCacheIndex[key] = m_iconCache.begin();
+		return &m_iconCache.front().slot;
+	}
+
+	void FileDialog::m_trimIconCache()
+	{
+		const auto bytesPerIcon = static_cast<size_t>(ICON_ATLAS_CELL_STRIDE) * ICON_ATLAS_CELL_STRIDE * DEFAULT_ICON_CHANNELS;
+		const auto maxIcons = std::min(m_iconCacheMaxIcons, m_iconCacheMaxBytes / bytesPerIcon);
+		if (m_iconCache.size() <= maxIcons) {
+			return;
+		}
+
+		// paths showing an evicted icon look it up again
+		std::unordered_set<const IconAtlas::Slot*> evicted;
+		for (auto it = std::next(m_iconCache.begin(), maxIcons); it != m_iconCache.end(); ++it) {
+			evicted.insert(&it->slot);
+		}
+		std::erase_if(m_icons, [&evicted](const auto& icon) { return evicted.contains(icon.second); });
+
+		while (m_iconCache.size() > maxIcons) {
+			m_iconAtlas.release(m_iconCache.back().slot);
+			m_iconCacheIndex.erase(m_iconCache.back().key);
+			m_iconCache.pop_back();
+		}
+		std::erase_if(m_iconExtensionKeys, [this](const auto& extension) { return !m_iconCacheIndex.contains(extension.second); });
+	}
+
+	void FileDialog::m_forgetIconPaths()
+	{
+#ifdef __linux__
+		m_stopIconLoader();
+#endif
+		m_icons.clear();
+	}
+
+	std::optional<FileDialog::IconAtlas::Slot> FileDialog::m_readIconCacheFile(const std::string& key)
+	{
+		const auto icon = m_iconCacheFile.icons.find(key);
+		if (icon == m_iconCacheFile.icons.end()) {
+			return std::nullopt;
+		}
+
+		// a damaged bitmap is dropped, its icon is looked up and decoded again and the file written again
+		const uint8_t* bitmap = m_iconCacheFile.bitmaps + static_cast<size_t>(icon->second) * ICON_CACHE_BITMAP_SIZE;
+		uint64_t checksum;
+		memcpy(&checksum, m_iconCacheFile.checksums + static_cast<size_t>(icon->second) * sizeof(checksum), sizeof(checksum));
+		if (listingIndexChecksum(reinterpret_cast<const char*>(bitmap), ICON_CACHE_BITMAP_SIZE) != checksum) {
+			m_iconCacheFile.contents -= iconCacheEntryHash(key);
+			m_iconCacheFile.icons.erase(icon);
+			return std::nullopt;
+		}
+		return m_addIcon(bitmap, ICON_ATLAS_CELL_SIZE, ICON_ATLAS_CELL_SIZE, Format::RGBA);
+	}
+
+	void FileDialog::m_writeIconCacheFile()
+	{
+		if (m_iconCacheFilePath.empty() || !m_iconCacheFile.themeStamp) {
+			return;
+		}
+
+		// Only theme icons are saved, the stamp says nothing about icon files or default icons. Cached ones go
+		// first, most recently used first, then those of the file that weren't needed this time.
+		struct SavedIcon {
+			const std::string* key;
+			std::optional<IconAtlas::Slot> slot; // in the atlas, otherwise bitmap in the file
+			uint32_t bitmap;
+		};
+		std::vector<SavedIcon> icons;
+		std::unordered_set<std::string_view> keys;
+		size_t bytes = sizeof(IconCacheHeader) + alignListingIndex(m_iconCacheFile.theme.size()) + sizeof(uint32_t) + 8; // first offset, padding
+		const auto add = [&](const std::string& key, std::optional<IconAtlas::Slot> slot, uint32_t bitmap) {
+			const size_t size = ICON_CACHE_BITMAP_SIZE + sizeof(uint64_t) + sizeof(uint32_t) + key.size() + 1;
+			if (key.starts_with("theme:") && bytes + size <= m_iconCacheFileMaxBytes && keys.insert(key).second) {
+				icons.push_back(SavedIcon{&key, slot, bitmap});
+				bytes += size;
+			}
+		};
+		for (const auto& entry : m_iconCache) {
+			add(entry.key, entry.slot, 0);
+		}
+		for (const auto& [key, bitmap] : m_iconCacheFile.icons) {
+			add(key, std::nullopt, bitmap);
+		}
+
+		std::vector<std::pair<const std::string*, const std::string*>> extensions;
+		std::unordered_set<std::string_view> extensionsSaved;
+		for (const auto* extensionKeys : {&m_iconExtensionKeys, &m_iconCacheFile.extensionKeys}) {
+			for (const auto& [extension, key] : *extensionKeys) {
+				const size_t size = 2 * sizeof(uint32_t) + extension.size() + key.size() + 2;
+				if (keys.contains(key) && bytes + size <= m_iconCacheFileMaxBytes && extensionsSaved.insert(extension).second) {
+					extensions.emplace_back(&extension, &key);
+					bytes += size;
+				}
+			}
+		}
+
+		// nothing new since it was read or written last
+		uint64_t contents = 0;
+		for (const auto& icon : icons) {
+			contents += iconCacheEntryHash(*icon.key);
+		}
+		for (const auto& [extension, key] : extensions) {
+			contents += iconCacheEntryHash(*extension, *key);
+		}
+		if (contents == m_iconCacheFile.contents) {
+			return;
+		}
+		m_iconCacheFile.contents = contents;
+
+		std::vector<uint32_t> offsets{0};
+		std::string strings;
+		const auto addString = [&offsets, &strings](const std::string& text) {
+			strings += text;
+			strings += '\0';
+			offsets.push_back(static_cast<uint32_t>(strings.size()));
+		};
+		for (const auto& icon : icons) {
+			addString(*icon.key);
+		}
+		for (const auto& [extension, key] : extensions) {
+			addString(*extension);
+			addString(*key);
+		}
+
+		const size_t count = icons.size();
+		const size_t themeSize = alignListingIndex(m_iconCacheFile.theme.size());
+		const size_t indexSize = themeSize + count * sizeof(uint64_t) + offsets.size() * sizeof(uint32_t) + alignListingIndex(strings.size());
+
+		IconCacheHeader header{};
+		memcpy(header.magic, ICON_CACHE_MAGIC, sizeof(header.magic));
+		header.version = ICON_CACHE_VERSION;
+		header.headerSize = sizeof(IconCacheHeader);
+		header.payloadSize = indexSize + count * ICON_CACHE_BITMAP_SIZE;
+		header.themeStamp = *m_iconCacheFile.themeStamp;
+		header.cellSize = ICON_ATLAS_CELL_SIZE;
+		header.themeSize = static_cast<uint32_t>(m_iconCacheFile.theme.size());
+		header.iconCount = static_cast<uint32_t>(count);
+		header.extensionCount = static_cast<uint32_t>(extensions.size());
+		header.stringsSize = strings.size();
+
+		// serialized here, the atlas cells are copied without their border
+		std::string buffer(sizeof(header) + header.payloadSize, '\0');
+		char* payload = buffer.data() + sizeof(header);
+		char* checksums = payload + themeSize;
+		char* bitmaps = payload + indexSize;
+		memcpy(payload, m_iconCacheFile.theme.data(), m_iconCacheFile.theme.size());
+		memcpy(checksums + count * sizeof(uint64_t), offsets.data(), offsets.size() * sizeof(uint32_t));
+		memcpy(checksums + count * sizeof(uint64_t) + offsets.size() * sizeof(uint32_t), strings.data(), strings.size());
+
+		constexpr size_t pitch = ICON_ATLAS_PAGE_WIDTH * DEFAULT_ICON_CHANNELS;
+		constexpr size_t rowSize = ICON_ATLAS_CELL_SIZE * DEFAULT_ICON_CHANNELS;
+		for (size_t i = 0; i < count; i++) {
+			char* bitmap = bitmaps + i * ICON_CACHE_BITMAP_SIZE;
+			if (icons[i].slot) {
+				const uint8_t* cell = m_iconAtlas.cellPixels(*icons[i].slot) + pitch + DEFAULT_ICON_CHANNELS;
+				for (int y = 0; y < ICON_ATLAS_CELL_SIZE; y++) {
+					memcpy(bitmap + y * rowSize, cell + y * pitch, rowSize);
+				}
+				const uint64_t checksum = listingIndexChecksum(bitmap, ICON_CACHE_BITMAP_SIZE);
+				memcpy(checksums + i * sizeof(checksum), &checksum, sizeof(checksum));
+			} else {
+				// unchecked yet, it keeps its checksum so damage is still found
+				const size_t source = icons[i].bitmap;
+				memcpy(bitmap, m_iconCacheFile.bitmaps + source * ICON_CACHE_BITMAP_SIZE, ICON_CACHE_BITMAP_SIZE);
+				memcpy(checksums + i * sizeof(uint64_t), m_iconCacheFile.checksums + source * sizeof(uint64_t), sizeof(uint64_t));
+			}
+		}
+
+		header.checksum = listingIndexChecksum(payload, indexSize);
+		memcpy(buffer.data(), &header, sizeof(header));
+
+		FileWorkers::get().submit([file = m_iconCacheFilePath, buffer = std::move(buffer)]() {
+			std::error_code ec;
+			std::filesystem::create_directories(file.parent_path(), ec);
+			replaceFile(file, buffer);
+		});
+	}
+
+	std::optional<FileDialog::IconAtlas::Slot> FileDialog::m_addIcon(const uint8_t* data, int width, int height, Format format)
+	{
+		const auto slot = m_iconAtlas.allocate(SIZE_MAX);
+		if (!slot) {
+			return std::nullopt;
+		}
+		m_iconAtlas.write(*slot, data, width, height, format);
+
+		// a new or taller page has no texture for the icon's rows yet, the rest waits for m_syncIconAtlas
+		auto& page = m_iconAtlas.pages[slot->page];
+		if (page.uploadedRows != page.rows) {
+			m_uploadIconPage(page);
+		}
+		return slot;
+	}
+
+	FileDialog::IconImage FileDialog::m_iconImage(const IconAtlas::Slot* slot) const
+	{
+		if (slot == nullptr) {
+			return {};
+		}
+
+		const auto& page = m_iconAtlas.pages[slot->page];
+		const float x = static_cast<float>((slot->cell % ICON_ATLAS_COLUMNS) * ICON_ATLAS_CELL_STRIDE + 1);
+		const float y = static_cast<float>((slot->cell / ICON_ATLAS_COLUMNS) * ICON_ATLAS_CELL_STRIDE + 1);
+		const float height = static_cast<float>(page.uploadedRows * ICON_ATLAS_CELL_STRIDE);
+
+		IconImage image;
+		image.texture = page.texture;
+		image.uv0[0] = x / ICON_ATLAS_PAGE_WIDTH;
+		image.uv0[1] = y / height;
+		image.uv1[0] = (x + ICON_ATLAS_CELL_SIZE) / ICON_ATLAS_PAGE_WIDTH;
+		image.uv1[1] = (y + ICON_ATLAS_CELL_SIZE) / height;
+		return image;
+	}
+
+	const FileDialog::IconAtlas::Slot* FileDialog::m_loadDefaultIcon(bool isFolder)
+	{
+		// built in, also stands in while icons load, so it isn't counted as a hit or miss
+		const std::string key = isFolder ? "default:folder" : "default:file";
+		if (const auto slot = m_findIcon(key)) {
+			return slot;
+		}
+
+		// drawn in the text colour, m_syncDefaultIcons redraws them when the style changes
+		const auto& icon = isFolder ? DEFAULT_FOLDER_ICON : DEFAULT_FILE_ICON;
+		m_defaultIconTint = ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]);
+
+		std::vector<uint32_t> tinted(icon.size());
+		tintIcon(icon.data(), icon.size(), m_defaultIconTint, tinted.data());
+		const auto slot = m_addIcon(reinterpret_cast<const uint8_t*>(tinted.data()), DEFAULT_ICON_SIZE, DEFAULT_ICON_SIZE, Format::RGBA);
+		return slot ? m_storeIcon(key, *slot) : nullptr;
+	}
+
+	void FileDialog::m_syncDefaultIcons()
+	{
+		const uint32_t tint = ImGui::ColorConvertFloat4ToU32(ImGui::GetStyle().Colors[ImGuiCol_Text]);
+		if (tint == m_defaultIconTint) {
+			return;
+		}
+		m_defaultIconTint = tint;
+
+		// drawn again into the cells they have, every path showing one keeps pointing at it
+		std::vector<uint32_t> tinted(DEFAULT_ICON_SIZE * DEFAULT_ICON_SIZE);
+		for (const bool isFolder : {false, true}) {
+			const auto entry = m_iconCacheIndex.find(isFolder ? "default:folder" : "default:file");
+			if (entry != m_iconCacheIndex.end()) {
+				const auto& icon = isFolder ? DEFAULT_FOLDER_ICON : DEFAULT_FILE_ICON;
+				tintIcon(icon.data(), icon.size(), tint, tinted.data());
+				m_iconAtlas.write(entry->second->slot, reinterpret_cast<const uint8_t*>(tinted.data()), DEFAULT_ICON_SIZE, DEFAULT_ICON_SIZE, Format::RGBA);
+			}
+		}
+	}
+
+	void FileDialog::m_clearIcons()
+	{
+#ifdef __linux__
+		m_stopIconLoader();
+#endif
+
+		// the cells are freed here, m_syncIconAtlas gives up pages that end up empty
+		for (auto& entry : m_iconCache) {
+			m_iconAtlas.release(entry.slot);
+		}
+
+		m_iconCache.clear();
+		m_iconCacheIndex.clear();
+		m_iconExtensionKeys.clear();
+		m_failedIconKeys.clear();
+		m_icons.clear();
+	}
+
+	void FileDialog::m_uploadIconPage(IconAtlas::Page& page)
+	{
+		// the old texture may be in this frame's draw list already
+		if (page.texture != nullptr) {
+			m_iconAtlas.retiredTextures.push_back(page.texture);
+		}
+
+		page.texture = this->createTexture(page.pixels.data(), ICON_ATLAS_PAGE_WIDTH, page.rows * ICON_ATLAS_CELL_STRIDE, Format::RGBA);
+		page.uploadedRows = page.rows;
+		page.dirty = false;
+		page.freeCells.insert(page.freeCells.end(), page.releasedCells.begin(), page.releasedCells.end());
+		page.releasedCells.clear();
+	}
+
+	void FileDialog::m_syncIconAtlas()
+	{
+		// last frame has been drawn, nothing refers to replaced textures anymore
+		for (void* texture : m_iconAtlas.retiredTextures) {
+			this->deleteTexture(texture);
+		}
+		m_iconAtlas.retiredTextures.clear();
+
+		m_trimIconCache();
+		m_compactIconAtlas();
+
+		// icons added during the last frame showed up empty for that one frame
+		for (auto& page : m_iconAtlas.pages) {
+			if (page.dirty) {
+				m_uploadIconPage(page);
+			}
+		}
+	}
+
+	void FileDialog::m_compactIconAtlas()
+	{
+		auto& pages = m_iconAtlas.pages;
+
+		// nothing is drawn from the pages yet this frame, cells freed during the last one can be reused right away
+		for (auto& page : pages) {
+			page.freeCells.insert(page.freeCells.end(), page.releasedCells.begin(), page.releasedCells.end());
+			page.releasedCells.clear();
+		}
+
+		// the last page is moved into the holes of the others once they have room for all of it
+		while (!pages.empty()) {
+			const auto last = static_cast<uint32_t>(pages.size() - 1);
+			if (pages[last].usedCells != 0) {
+				size_t room = 0;
+				for (uint32_t i = 0; i < last; i++) {
+					room += pages[i].freeCells.size() + (ICON_ATLAS_COLUMNS * ICON_ATLAS_MAX_ROWS - pages[i].nextCell);
+				}
+				if (room < pages[last].usedCells) {
+					break;
+				}
+
+				for (auto& entry : m_iconCache) {
+					if (entry.slot.page == last) {
+						const auto moved = *m_iconAtlas.allocate(last);
+						m_iconAtlas.copy(entry.slot, moved);
+						m_iconAtlas.release(entry.slot);
+						entry.slot = moved; // m_icons points at it
+					}
+				}
+			}
+
+			if (pages[last].texture != nullptr) {
+				this->deleteTexture(pages[last].texture);
+			}
+			pages.pop_back();
+		}
+	}
+
+	void FileDialog::m_refreshIconPreview()
+	{
+		// images are picked from the complete listing
+		if (m_contentLoading) {
+			return;
+		}
+
+		if (m_zoom >= ZOOM_LEVEL_RENDER_PREVIEW) {
+			if (!m_previewLoader && m_isResponsive(m_content.directory)) {
+				std::vector<std::pair<uint32_t, std::filesystem::path>> entries;
+				for (uint32_t i = 0; i < m_content.size(); i++) {
+					const auto type = m_content.typeKey(i);
+					if (!m_isRemoved(i) && !m_iconPreviews.contains(i) && (type == "png" || type == "jpg" || type == "jpeg" || type == "bmp" || type == "tga")) {
+						entries.emplace_back(i, m_content.path(i));
+					}
+				}
+
+				m_previewLoader = std::make_shared<PreviewLoader>();
+				std::thread(&FileDialog::m_loadPreview, m_previewLoader, std::move(entries)).detach();
+			}
+		} else {
+			m_clearIconPreview();
+		}
+	}
+
+	void FileDialog::m_clearIconPreview()
+	{
+		m_stopPreviewLoader();
+
+		for (auto& [index, preview] : m_iconPreviews) {
+			if (preview.texture != nullptr) {
+				this->deleteTexture(preview.texture);
+			}
+
+			if (preview.data != nullptr) {
+				stbi_image_free(preview.data);
+			}
+		}
+		m_iconPreviews.clear();
+	}
+
+	void FileDialog::m_stopPreviewLoader()
+	{
+		if (!m_previewLoader) {
+			return;
+		}
+
+		{
+			// under the lock, so the loader can't add images after these are freed
+			std::lock_guard<std::mutex> lock{m_previewLoader->mutex};
+			m_previewLoader->running = false;
+			for (auto& [index, preview] : m_previewLoader->pending) {
+				stbi_image_free(preview.data);
+			}
+			m_previewLoader->pending.clear();
+		}
+		m_previewLoader.reset();
+	}
+
+	void FileDialog::m_loadPreview(std::shared_ptr<PreviewLoader> loader, std::vector<std::pair<uint32_t, std::filesystem::path>> entries)
+	{
+		for (size_t i = 0; loader->running && i < entries.size(); i++) {
+			int width, height, nrChannels;
+			unsigned char* image = stbi_load(entries[i].second.u8string().c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+			loader->progress++;
+
+			if (image == nullptr || width == 0 || height == 0) {
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock{loader->mutex};
+			if (!loader->running) {
+				stbi_image_free(image); // stopped while decoding, nobody will pick it up
+				break;
+			}
+			loader->pending.emplace_back(entries[i].first, IconPreview{nullptr, image, width, height});
+		}
+
+		loader->running = false;
+	}
+
+	void FileDialog::m_syncPreview()
+	{
+		if (!m_previewLoader) {
+			return;
+		}
+
+		std::vector<std::pair<uint32_t, IconPreview>> pending;
+		{
+			std::lock_guard<std::mutex> lock{m_previewLoader->mutex};
+			pending.swap(m_previewLoader->pending);
+		}
+
+		// textures can only be created on the render thread
+		for (auto& [index, preview] : pending) {
+			preview.texture = this->createTexture(preview.data, preview.width, preview.height, Format::RGBA);
+			stbi_image_free(preview.data);
+			preview.data = nullptr;
+			m_iconPreviews[index] = preview;
+		}
+	}
+
+	void FileDialog::m_setDirectory(const std::filesystem::path& p, bool addHistory)
+	{
+		bool isSameDir = m_currentDirectory == p;
+
+		if (addHistory && !isSameDir) {
+			m_backHistory.push(m_currentDirectory);
+		}
+
+		m_currentDirectory = p;
+#ifdef _WIN32
+		// drives don't work well without the backslash symbol
+		if (p.u8string().size() == 2 && p.u8string()[1] == ':') {
+			m_currentDirectory = std::filesystem::u8path(p.u8string() + "\\");
+		}
+#endif
+
+		m_resetContent();
+		m_searchingSubfolders = false;
+
+		if (!isSameDir) {
+			m_searchBuffer.clear();
+			m_forgetIconPaths();
+		}
+
+		m_updateView(true); // picks up the current query for the entries streamed in by m_syncContent
+
+		if (m_currentDirectory.u8string() == "Quick Access" || m_currentDirectory.u8string() == "This PC") {
+			for (auto& node : m_treeCache) {
+				if (node->path == m_currentDirectory) {
+					for (auto& c : node->children) {
+						// an entry on a mount that doesn't answer is left out
+						const auto child = c->path;
+						const auto entry = m_callFileSystem(child, FILE_STAT_TIMEOUT, [child]() { Listing entry; entry.add(child); return entry; });
+						if (entry) {
+							m_content.append(*entry);
+						}
+					}
+				}
+			}
+
+			m_sortContent();
+			m_refreshIconPreview();
+		} else {
+			const auto directory = m_currentDirectory;
+			auto opened = m_callFileSystem(directory, FILE_STAT_TIMEOUT, [directory]() {
+				std::error_code ec;
+				return std::make_pair(std::filesystem::weakly_canonical(directory, ec).u8string(), DirectoryStamp{directory});
+			});
+			if (!opened) {
+				return; // m_renderContent offers to retry
+			}
+
+			auto& [key, stamp] = *opened;
+			m_contentListingStamp = stamp;
+			m_contentRevalidationStamp = stamp;
+			m_contentListingKey = std::move(key);
+			if (const auto listing = m_findListing(m_contentListingKey, stamp)) {
+				m_content = *listing;
+				m_startWatch();
+				m_sortContent();
+				m_refreshIconPreview();
+				m_startFolderSizes();
 			} else {
-				m_isOpen = false;
+				// The directory is enumerated on m_contentLoader and handed over in m_syncContent, changes made
+				// meanwhile are queued by the watch and applied afterwards. The loader reads and checks the listing
+				// index first, if the directory is there that's shown until the whole directory has been read.
+				m_content.directory = m_currentDirectory;
+				m_startWatch();
+				m_startContentLoader([directory, root = m_listingIndexPath, key = m_contentListingKey](std::shared_ptr<ContentLoader> loader) {
+					auto indexed = std::make_unique<IndexedListing>();
+					if (m_readListingIndex(root, key, indexed->content, indexed->stamp)) {
+						indexed->content.directory = directory;
+						std::lock_guard<std::mutex> lock{loader->mutex};
+						loader->indexed = std::move(indexed);
+					}
+					m_loadContent(std::move(loader), directory);
+				});
+			}
+		}
+	}
+
+	void FileDialog::m_resetContent()
+	{
+		m_stopContentLoader();
+		m_stopFolderSizes();
+		m_contentFolderSizes.clear();
+		m_clearIconPreview();
+		m_stopWatch();
+		m_content.clear();
+		m_content.directory.clear();
+		m_contentRemoved.clear();
+		m_contentNameIndex.clear();
+		m_clearDisplayText();
+		m_order.clear();
+		m_orderRank.clear();
+		m_view.clear();
+		m_clearSelection();
+	}
+
+	void FileDialog::m_search()
+	{
+		m_clearSelection();
+
+		const bool isVirtualDirectory = m_currentDirectory.u8string() == "Quick Access" || m_currentDirectory.u8string() == "This PC";
+		if (m_searchSubfolders && !m_searchBuffer.empty() && !isVirtualDirectory) {
+			// every keystroke starts a new walk, the old one is cancelled by m_resetContent
+			m_resetContent();
+			m_searchingSubfolders = true;
+			m_updateView(true);
+
+			// the results are full paths and never cached
+			m_contentListingKey.clear();
+			m_startContentLoader([root = m_currentDirectory, query = m_viewQuery](std::shared_ptr<ContentLoader> loader) {
+				m_searchContent(std::move(loader), root, query);
+			});
+		} else if (m_searchingSubfolders) {
+			m_setDirectory(m_currentDirectory, false); // back to the directory's own listing
+		} else {
+			m_updateView(false);
+		}
+	}
+
+	void FileDialog::m_searchContent(std::shared_ptr<ContentLoader> loader, std::filesystem::path root, std::string query)
+	{
+		const size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+		const uint64_t queryMask = characterMask(query);
+
+		// matches are collected per worker and handed to m_syncContent like a directory listing
+		std::vector<Listing> chunks(threadCount);
+		const auto flush = [&loader](Listing& chunk) {
+			std::lock_guard<std::mutex> lock{loader->mutex};
+			loader->pending.append(chunk);
+			chunk.clear();
+		};
+
+		// every name is folded into its worker's buffer, only the matches are copied
+		std::vector<std::string> keys(threadCount);
+		const auto matches = [&query, queryMask, &keys](size_t worker, std::string_view name) {
+			auto& key = keys[worker];
+			foldCase(name, key);
+			return (queryMask & ~characterMask(key)) == 0 && fuzzyMatch(key, query) != NO_MATCH;
+		};
+
+#ifdef __linux__
+		// symlinked directories are followed, so every directory is entered once per (device, inode)
+		std::mutex visitedMutex;
+		std::unordered_set<std::pair<uint64_t, uint64_t>, DeviceInodeHash> visited;
+		const auto enter = [&visitedMutex, &visited](const struct stat& attr) {
+			std::lock_guard<std::mutex> lock{visitedMutex};
+			return visited.emplace(attr.st_dev, attr.st_ino).second;
+		};
+
+		struct stat rootAttr;
+		if (stat(root.c_str(), &rootAttr) != 0 || !S_ISDIR(rootAttr.st_mode)) {
+			loader->running = false;
+			return;
+		}
+		enter(rootAttr);
+
+		walkDirectories(std::vector<std::string>{root.native()}, threadCount, loader->running, [&](size_t worker, const std::string& directory, std::vector<std::string>& subdirectories) {
+			DIR* dir = opendir(directory.c_str());
+			if (dir == nullptr) {
+				return;
+			}
+			const int dirFd = dirfd(dir);
+
+			for (dirent* ent = readdir(dir); loader->running && ent != nullptr; ent = readdir(dir)) {
+				loader->progress++;
+				const char* name = ent->d_name;
+				if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+					continue;
+				}
+
+				const bool isMatch = matches(worker, name);
+				const bool mayBeDirectory = ent->d_type == DT_DIR || ent->d_type == DT_LNK || ent->d_type == DT_UNKNOWN;
+
+				// files that don't match are never stat'ed
+				struct stat attr;
+				if (!(isMatch || mayBeDirectory) || fstatat(dirFd, name, &attr, 0) != 0) {
+					continue;
+				}
+
+				const std::string path = directory + "/" + name;
+				const bool isDirectory = S_ISDIR(attr.st_mode);
+
+				if (isMatch) {
+					chunks[worker].add(path, isDirectory, isDirectory ? 0 : static_cast<size_t>(attr.st_size), attr.st_mtime);
+					if (chunks[worker].size() >= CONTENT_LOADER_CHUNK_SIZE) {
+						flush(chunks[worker]);
+					}
+				}
+
+				if (isDirectory && enter(attr)) {
+					subdirectories.push_back(path);
+				}
+			}
+
+			closedir(dir);
+		});
+#else
+		// symlinks aren't followed here, which rules out loops without tracking inodes
+		walkDirectories(std::vector<std::string>{root.u8string()}, threadCount, loader->running, [&](size_t worker, const std::string& directory, std::vector<std::string>& subdirectories) {
+			std::error_code ec;
+			std::filesystem::directory_iterator it{std::filesystem::u8path(directory), ec};
+			for (; loader->running && !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+				loader->progress++;
+				std::error_code entryEc;
+				if (matches(worker, it->path().filename().u8string())) {
+					chunks[worker].add(it->path());
+					if (chunks[worker].size() >= CONTENT_LOADER_CHUNK_SIZE) {
+						flush(chunks[worker]);
+					}
+				}
+
+				if (it->is_directory(entryEc) && !it->is_symlink(entryEc)) {
+					subdirectories.push_back(it->path().u8string());
+				}
+			}
+		});
+#endif
+
+		for (auto& chunk : chunks) {
+			flush(chunk);
+		}
+		loader->running = false;
+	}
+
+	void FileDialog::m_startContentLoader(std::function<void(std::shared_ptr<ContentLoader>)> load)
+	{
+		m_contentLoading = true;
+		m_contentLoader = std::make_shared<ContentLoader>();
+		m_contentProgress = 0;
+		m_contentProgressTime = std::chrono::steady_clock::now();
+		std::thread(std::move(load), m_contentLoader).detach();
+	}
+
+	void FileDialog::m_stopContentLoader()
+	{
+		// never joined, it finishes on its own (or stays stuck in a hung mount) and frees what it read
+		if (m_contentLoader) {
+			m_contentLoader->running = false;
+			m_contentLoader.reset();
+		}
+
+		m_contentLoading = false;
+		m_contentRevalidating = false;
+	}
+
+	void FileDialog::m_loadContent(std::shared_ptr<ContentLoader> loader, std::filesystem::path directory)
+	{
+		Listing chunk;
+		chunk.directory = directory;
+
+		const auto flush = [&loader, &chunk]() {
+			std::lock_guard<std::mutex> lock{loader->mutex};
+			loader->pending.append(chunk);
+			chunk.clear();
+		};
+
+#ifdef __linux__
+		// fast path: one statx relative to the directory fd per entry, so no path is resolved more than once.
+		// Nothing is filtered here, the whole listing goes to the cache.
+		DIR* dir = opendir(directory.c_str());
+		if (dir != nullptr) {
+			const int dirFd = dirfd(dir);
+
+			for (dirent* ent = readdir(dir); loader->running && ent != nullptr; ent = readdir(dir)) {
+				loader->progress++;
+				const char* name = ent->d_name;
+				if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+					continue;
+				}
+
+				// the stat follows symlinks and types DT_UNKNOWN entries, one that can't be stat'ed is left out
+				bool isDirectory = false;
+				size_t size = 0;
+				time_t dateModified = 0, dateCreated = 0;
+				if (!statAt(dirFd, name, isDirectory, size, dateModified, dateCreated)) {
+					continue;
+				}
+
+				chunk.add(name, isDirectory, size, dateModified, dateCreated);
+
+				if (chunk.size() >= CONTENT_LOADER_CHUNK_SIZE) {
+					flush();
+				}
+			}
+
+			closedir(dir);
+		}
+#else
+		std::error_code ec;
+		if (std::filesystem::exists(directory, ec)) {
+			std::filesystem::directory_iterator it{directory, ec};
+			for (; loader->running && !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+				loader->progress++;
+				chunk.add(it->path());
+
+				if (chunk.size() >= CONTENT_LOADER_CHUNK_SIZE) {
+					flush();
+				}
+			}
+		}
+#endif
+
+		flush();
+		loader->running = false;
+	}
+
+	void FileDialog::m_syncContent()
+	{
+		if (!m_contentLoading || !m_contentLoader) {
+			return;
+		}
+
+		// read the flag before draining so the last chunk can't be missed
+		bool finished = !m_contentLoader->running;
+
+		// a loader that stopped making progress is stuck in the file system, m_renderContent offers to
+		// give up on it, and withdraws the offer if it moves again
+		const auto progress = m_contentLoader->progress.load();
+		const auto now = std::chrono::steady_clock::now();
+		if (progress != m_contentProgress) {
+			if (m_contentProgressTime + LOADER_STALL_TIMEOUT < now) {
+				m_unresponsiveMounts.erase(mountOf(m_currentDirectory));
+			}
+			m_contentProgress = progress;
+			m_contentProgressTime = now;
+		} else if (!finished && m_contentProgressTime + LOADER_STALL_TIMEOUT < now) {
+			m_unresponsiveMounts.insert(mountOf(m_currentDirectory));
+		}
+
+		// the indexed listing stays on screen until the new one is complete, m_revalidateContent applies the difference
+		if (!m_contentRevalidating) {
+			std::unique_ptr<IndexedListing> indexed;
+			{
+				std::lock_guard<std::mutex> lock{m_contentLoader->mutex};
+				indexed.swap(m_contentLoader->indexed);
+			}
+			if (indexed) {
+				m_content = std::move(indexed->content);
+				m_contentListingStamp = indexed->stamp;
+				m_contentRevalidating = true;
+				m_sortContent();
+			}
+		}
+		if (m_contentRevalidating) {
+			if (finished) {
+				m_revalidateContent();
+			}
+			return;
+		}
+
+		Listing pending;
+		{
+			std::lock_guard<std::mutex> lock{m_contentLoader->mutex};
+			std::swap(pending, m_contentLoader->pending);
+		}
+
+		// unsorted until the scan is done, m_sortContent puts them in place
+		const auto start = static_cast<uint32_t>(m_content.size());
+		m_content.append(pending);
+		for (uint32_t index = start; index < m_content.size(); index++) {
+			if (m_matchesFilter(index) && m_matchQuery(index) != NO_MATCH) {
+				m_view.push_back(index);
 			}
+			m_orderRank.push_back(static_cast<uint32_t>(m_order.size()));
+			m_order.push_back(index);
 		}
 
-		return isMe && !m_isOpen;
+		if (finished) {
+			m_contentLoader.reset();
+			m_contentLoading = false;
+			m_writeListingIndex(m_contentListingKey, m_contentListingStamp, m_content);
+			m_storeListing(m_contentListingKey, m_contentListingStamp, Listing(m_content));
+			m_sortContent();
+			m_refreshIconPreview();
+			m_startFolderSizes();
+		}
 	}
-	void FileDialog::close()
+
+	void FileDialog::m_revalidateContent()
 	{
-		m_currentKey.clear();
-		m_backHistory = std::stack<std::filesystem::path>();
-		m_forwardHistory = std::stack<std::filesystem::path>();
-		confirmationPopup = false;
+		Listing fresh;
+		{
+			std::lock_guard<std::mutex> lock{m_contentLoader->mutex};
+			std::swap(fresh, m_contentLoader->pending);
+		}
+		m_contentLoader.reset();
+		fresh.directory = m_content.directory;
+		m_contentRevalidating = false;
+		m_contentLoading = false;
+
+		// names that came, went or changed, m_applyChanges reads them once more and updates m_content in place
+		std::vector<std::string> names;
+		std::vector<uint8_t> isListed(m_content.size(), false);
+		for (uint32_t i = 0; i < fresh.size(); i++) {
+			const int64_t found = m_findEntry(fresh.name(i));
+			if (found < 0) {
+				names.emplace_back(fresh.name(i));
+				continue;
+			}
 
-		for (auto& node : m_treeCache) {
-			for (auto& child : node->children) {
-				child->children.clear();
-				child->read = false;
+			const auto index = static_cast<uint32_t>(found);
+			isListed[index] = true;
+			if (fresh.isDirectory(i) != m_content.isDirectory(index) || fresh.sizes[i] != m_content.sizes[index] ||
+				fresh.datesModified[i] != m_content.datesModified[index] || fresh.datesCreated[i] != m_content.datesCreated[index]) {
+				names.emplace_back(fresh.name(i));
+			}
+		}
+		for (uint32_t i = 0; i < m_content.size(); i++) {
+			if (!isListed[i] && !m_isRemoved(i)) {
+				names.emplace_back(m_content.name(i));
 			}
 		}
 
-		// free icon textures
-		m_clearIconPreview();
-		m_clearIcons();
+		const bool changed = !names.empty() || !(m_contentListingStamp == m_contentRevalidationStamp);
+		m_applyChanges(std::move(names));
+
+		m_contentListingStamp = m_contentRevalidationStamp;
+		if (changed) {
+			m_writeListingIndex(m_contentListingKey, m_contentListingStamp, fresh);
+		}
+		m_storeListing(m_contentListingKey, m_contentListingStamp, std::move(fresh));
+		m_refreshIconPreview();
+		if (!m_folderSizeLoader) { // m_applyChanges started it already if anything changed
+			m_startFolderSizes();
+		}
 	}
 
-	void FileDialog::removeFavorite(const std::string& path)
+	bool FileDialog::m_readListingIndex(const std::filesystem::path& root, const std::string& key, Listing& content, DirectoryStamp& stamp)
 	{
-		auto itr = std::find(m_favorites.begin(), m_favorites.end(), m_currentDirectory.u8string());
+		if (root.empty() || key.empty()) {
+			return false;
+		}
 
-		if (itr != m_favorites.end())
-			m_favorites.erase(itr);
+		// runs on the content loader, which may get stuck in a hung mount anyway
+		const auto file = listingIndexFile(root, key);
+		const MappedFile mapped{file};
+		if (mapped.data == nullptr || mapped.size < sizeof(ListingIndexHeader)) {
+			return false;
+		}
 
-		// remove from sidebar
-		for (auto& p : m_treeCache) {
-			if (p->path == "Quick Access") {
-				for (size_t i = 0; i < p->children.size(); i++)
-					if (p->children[i]->path == path) {
-						p->children.erase(p->children.begin() + i);
-						break;
-					}
-				break;
+		ListingIndexHeader header;
+		memcpy(&header, mapped.data, sizeof(header));
+		if (memcmp(header.magic, LISTING_INDEX_MAGIC, sizeof(header.magic)) != 0 || header.version != LISTING_INDEX_VERSION ||
+			header.headerSize != sizeof(ListingIndexHeader) || header.payloadSize != mapped.size - sizeof(header)) {
+			return false;
+		}
+
+		const char* payload = mapped.data + sizeof(header);
+		if (listingIndexChecksum(payload, header.payloadSize) != header.checksum) {
+			return false;
+		}
+
+		// an intact file can still be a different key with the same hash, or lie about its sizes
+		const size_t count = header.entryCount;
+		const size_t keySize = alignListingIndex(header.keySize);
+		const size_t arraysSize = keySize + count * 3 * sizeof(int64_t) + (count + 1) * sizeof(uint32_t) + count;
+		if (arraysSize > header.payloadSize || header.payloadSize - arraysSize != header.namesSize ||
+			std::string_view{payload, header.keySize} != key) {
+			return false;
+		}
+
+		const char* sizes = payload + keySize;
+		const char* datesModified = sizes + count * sizeof(int64_t);
+		const char* datesCreated = datesModified + count * sizeof(int64_t);
+		const char* offsets = datesCreated + count * sizeof(int64_t);
+		const char* directoryFlags = offsets + (count + 1) * sizeof(uint32_t);
+		const char* names = directoryFlags + count;
+
+		const auto read = [](const char* array, size_t i, auto value) {
+			memcpy(&value, array + i * sizeof(value), sizeof(value));
+			return value;
+		};
+
+		uint32_t start = read(offsets, 0, uint32_t{});
+		if (start != 0 || read(offsets, count, uint32_t{}) != header.namesSize) {
+			return false;
+		}
+		for (size_t i = 0; i < count; i++) {
+			const uint32_t end = read(offsets, i + 1, uint32_t{});
+			if (end <= start || end > header.namesSize || names[end - 1] != '\0') {
+				return false;
 			}
+			start = end;
+		}
+
+		content.clear();
+		start = 0;
+		for (size_t i = 0; i < count; i++) {
+			const uint32_t end = read(offsets, i + 1, uint32_t{});
+			content.add(std::string_view{names + start, end - start - 1}, directoryFlags[i] != 0, read(sizes, i, uint64_t{}),
+				static_cast<time_t>(read(datesModified, i, int64_t{})), static_cast<time_t>(read(datesCreated, i, int64_t{})));
+			start = end;
 		}
+
+		stamp = DirectoryStamp{};
+		stamp.valid = true;
+		stamp.dateModified = header.dateModified;
+		stamp.device = header.device;
+		stamp.inode = header.inode;
+
+		// the size limit drops the least recently used directories first
+		std::error_code ec;
+		std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), ec);
+		return true;
 	}
 
-	void FileDialog::addFavorite(const std::string& path)
+	void FileDialog::m_writeListingIndex(const std::string& key, const DirectoryStamp& stamp, const Listing& content)
 	{
-		if (std::count(m_favorites.begin(), m_favorites.end(), path) > 0)
+		if (m_listingIndexPath.empty() || key.empty() || !stamp.valid) {
 			return;
+		}
 
-		if (!std::filesystem::exists(std::filesystem::u8path(path)))
+		const size_t count = content.size();
+		const size_t keySize = alignListingIndex(key.size());
+		const size_t namesSize = content.names.data.size();
+		const size_t payloadSize = keySize + count * 3 * sizeof(int64_t) + (count + 1) * sizeof(uint32_t) + count + namesSize;
+		if (sizeof(ListingIndexHeader) + payloadSize > m_listingIndexMaxBytes) {
 			return;
+		}
 
-		m_favorites.push_back(path);
-		
-		// add to sidebar
-		for (auto& p : m_treeCache) {
-			if (p->path == "Quick Access") {
-				p->children.emplace_back(std::make_unique<FileTreeNode>(path));
-				break;
+		ListingIndexHeader header{};
+		memcpy(header.magic, LISTING_INDEX_MAGIC, sizeof(header.magic));
+		header.version = LISTING_INDEX_VERSION;
+		header.headerSize = sizeof(ListingIndexHeader);
+		header.payloadSize = payloadSize;
+		header.dateModified = stamp.dateModified;
+		header.device = stamp.device;
+		header.inode = stamp.inode;
+		header.keySize = static_cast<uint32_t>(key.size());
+		header.entryCount = static_cast<uint32_t>(count);
+		header.namesSize = namesSize;
+
+		// serialized here, written and renamed into place on a file worker
+		std::string buffer(sizeof(header) + payloadSize, '\0');
+		char* out = buffer.data() + sizeof(header);
+		memcpy(out, key.data(), key.size());
+		out += keySize;
+		memcpy(out, content.sizes.data(), count * sizeof(uint64_t));
+		out += count * sizeof(uint64_t);
+		for (const auto& dates : {&content.datesModified, &content.datesCreated}) {
+			for (size_t i = 0; i < count; i++) {
+				const auto date = static_cast<int64_t>((*dates)[i]);
+				memcpy(out, &date, sizeof(date));
+				out += sizeof(date);
 			}
 		}
+		memcpy(out, content.names.offsets.data(), (count + 1) * sizeof(uint32_t));
+		out += (count + 1) * sizeof(uint32_t);
+		memcpy(out, content.directoryFlags.data(), count);
+		out += count;
+		memcpy(out, content.names.data.data(), namesSize);
+
+		header.checksum = listingIndexChecksum(buffer.data() + sizeof(header), payloadSize);
+		memcpy(buffer.data(), &header, sizeof(header));
+
+		FileWorkers::get().submit([root = m_listingIndexPath, maxBytes = m_listingIndexMaxBytes, file = listingIndexFile(m_listingIndexPath, key), buffer = std::move(buffer)]() {
+			writeListingIndexFile(root, maxBytes, file, buffer);
+		});
 	}
-	
-	void FileDialog::m_select(const std::filesystem::path& path, bool isCtrlDown)
-	{
-		bool multiselect = isCtrlDown && m_isMultiselect;
 
-		if (!multiselect) {
-			m_selections.clear();
-			m_selections.push_back(path);
-		} else {
-			auto it = std::find(m_selections.begin(), m_selections.end(), path);
-			if (it != m_selections.end()) {
-				m_selections.erase(it);
-			} else {
-				m_selections.push_back(path);
-			}
+	void FileDialog::m_startFolderSizes()
+	{
+		m_stopFolderSizes();
+		if (!m_folderSizesEnabled || m_contentLoading || m_content.directory.empty() || !m_isResponsive(m_content.directory)) {
+			return; // Quick Access, This PC and subfolder search results are left alone
 		}
 
-		if (m_selections.size() == 1) {
-			m_inputTextbox = m_selections[0].filename().u8string();
-			if (m_inputTextbox.size() == 0) {
-				m_inputTextbox = m_selections[0].u8string(); // drive
+		// totals of the current directory, folders add theirs as they come in
+		std::vector<std::pair<uint32_t, std::filesystem::path>> folders;
+		m_folderSizeTotal = FolderSize{};
+		m_folderSizesCount = 0;
+		m_folderSizesDone = 0;
+		for (uint32_t index : m_order) {
+			m_folderSizeTotal.entries++;
+			if (!m_content.isDirectory(index)) {
+				m_folderSizeTotal.bytes += m_content.sizes[index];
+				continue;
 			}
-		} else {
-			std::string textboxVal = "";
-			for (const auto& sel : m_selections) {
-				std::string filename = sel.filename().u8string();
-				if (filename.size() == 0) {
-					filename = sel.u8string();
-				}
 
-				textboxVal += "\"" + filename + "\", ";
+			m_folderSizesCount++;
+			if (const auto folderSize = m_contentFolderSizes.find(index); folderSize != m_contentFolderSizes.end()) {
+				m_folderSizeTotal.bytes += folderSize->second.bytes;
+				m_folderSizeTotal.entries += folderSize->second.entries;
+				m_folderSizesDone++;
+			} else {
+				folders.emplace_back(index, m_content.path(index)); // in sort order, so the first rows tend to fill in first
 			}
+		}
 
-			m_inputTextbox = textboxVal.substr(0, textboxVal.size() - 2).c_str();
+		if (!folders.empty()) {
+			m_folderSizeLoader = std::make_shared<FolderSizeLoader>();
+			std::thread(&FileDialog::m_loadFolderSizes, m_folderSizeLoader, m_folderSizeCache, std::move(folders)).detach();
 		}
 	}
 
-	bool FileDialog::m_finalize(const std::string& filename)
+	void FileDialog::m_stopFolderSizes()
 	{
-		auto path = std::filesystem::u8path(filename);
-		bool hasResult = (!filename.empty() && m_type != DialogType::openDirectory) || m_type == DialogType::openDirectory;
-		
-		if (hasResult) {
-			if (m_type == DialogType::saveFile) {
-				// add the extension
-				if (m_filterSelection < m_filterExtensions.size() && m_filterExtensions[m_filterSelection].size() > 0) {
-					if (!path.has_extension()) {
-						std::string extAdd = m_filterExtensions[m_filterSelection][0];
-						path.replace_extension(extAdd);
-						m_inputTextbox = path.u8string();
-					}
-				}
+		// never joined, like m_contentLoader
+		if (m_folderSizeLoader) {
+			m_folderSizeLoader->running = false;
+			m_folderSizeLoader.reset();
+		}
+	}
 
-				if (std::filesystem::exists(m_currentDirectory / path) &&
-					!confirmationPopup) {
-					// ask to confirm if overwrite 
-					// shouldn't call OpenPopup here because m_finalize may be called in a ID stack 
-					// level different to where we call BeginPopupModal
-					confirmationPopup = true;
-					return false;
-				}
+	void FileDialog::m_loadFolderSizes(std::shared_ptr<FolderSizeLoader> loader, std::shared_ptr<FolderSizeCache> cache, std::vector<std::pair<uint32_t, std::filesystem::path>> folders)
+	{
+		// every folder is walked as its own root, so each one is reported as soon as its subtree is done
+		struct Root {
+			uint32_t index;
+			std::string key;
+			DirectoryStamp stamp;
+			std::atomic<uint64_t> bytes{0};
+			std::atomic<uint64_t> entries{0};
+			std::atomic<size_t> pending{1}; // directories of this subtree queued or being visited
+		};
+		struct Item {
+			std::string path;
+			size_t root;
+		};
+
+		std::vector<Root> roots(folders.size());
+		std::vector<Item> items;
+		for (size_t i = 0; i < folders.size(); i++) {
+			auto& root = roots[i];
+			root.index = folders[i].first;
+			root.key = folders[i].second.u8string();
+			root.stamp = DirectoryStamp{folders[i].second};
+
+			std::scoped_lock lock{cache->mutex, loader->mutex};
+			const auto cached = cache->entries.find(root.key);
+			if (root.stamp.valid && cached != cache->entries.end() && cached->second.first == root.stamp) {
+				loader->pending.emplace_back(root.index, cached->second.second);
+			} else {
+#ifdef _WIN32
+				items.push_back(Item{root.key, i});
+#else
+				items.push_back(Item{folders[i].second.native(), i});
+#endif
 			}
+		}
 
-			if (!m_isMultiselect || m_selections.size() <= 1) {
-				if (path.is_absolute()) {
-					m_result.push_back(path);
-				} else {
-					m_result.push_back(m_currentDirectory / path);
-				}
+		const auto finish = [&loader, &cache](Root& root) {
+			const FolderSize size{root.bytes, root.entries};
 
-				if (m_type == DialogType::openDirectory || m_type == DialogType::openFile) {
-					if (!std::filesystem::exists(m_result.back())) {
-						m_result.clear();
-						return false;
-					}
+			std::scoped_lock lock{cache->mutex, loader->mutex};
+			if (root.stamp.valid) {
+				if (cache->entries.size() >= MAX_FOLDER_SIZE_CACHE_ENTRIES) {
+					cache->entries.clear();
 				}
+				cache->entries[root.key] = {root.stamp, size};
 			}
-			else {
-				for (const auto& sel : m_selections) {
-					if (sel.is_absolute()) {
-						m_result.push_back(sel);
-					} else {
-						m_result.push_back(m_currentDirectory / sel);
+			loader->pending.emplace_back(root.index, size);
+		};
+
+		const size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+		walkDirectories(std::move(items), threadCount, loader->running, [&](size_t, const Item& directory, std::vector<Item>& subdirectories) {
+			uint64_t bytes = 0, entries = 0;
+
+			// symbolic links count as entries but are never followed
+#ifdef __linux__
+			if (DIR* dir = opendir(directory.path.c_str())) {
+				const int dirFd = dirfd(dir);
+
+				for (dirent* ent = readdir(dir); loader->running && ent != nullptr; ent = readdir(dir)) {
+					loader->progress++;
+					const char* name = ent->d_name;
+					if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+						continue;
 					}
 
-					if (m_type == DialogType::openDirectory || m_type == DialogType::openFile) {
-						if (!std::filesystem::exists(m_result.back())) {
-							m_result.clear();
-							return false;
-						}
+					entries++;
+					if (ent->d_type == DT_DIR) {
+						subdirectories.push_back(Item{directory.path + "/" + name, directory.root});
+						continue;
+					}
+
+					struct stat attr;
+					if (fstatat(dirFd, name, &attr, AT_SYMLINK_NOFOLLOW) != 0) {
+						continue;
+					}
+					if (S_ISDIR(attr.st_mode)) {
+						subdirectories.push_back(Item{directory.path + "/" + name, directory.root});
+					} else if (S_ISREG(attr.st_mode)) {
+						bytes += static_cast<uint64_t>(attr.st_size);
 					}
 				}
+
+				closedir(dir);
 			}
-		}
+#else
+			std::error_code ec;
+			std::filesystem::directory_iterator it{std::filesystem::u8path(directory.path), ec};
+			for (; loader->running && !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+				loader->progress++;
+				std::error_code entryEc;
+				const auto status = it->symlink_status(entryEc);
+
+				entries++;
+				if (std::filesystem::is_directory(status)) {
+					subdirectories.push_back(Item{it->path().u8string(), directory.root});
+				} else if (std::filesystem::is_regular_file(status)) {
+					const auto size = it->file_size(entryEc);
+					bytes += entryEc ? 0 : static_cast<uint64_t>(size);
+				}
+			}
+#endif
 
-		m_isOpen = false;
+			if (!loader->running) {
+				return; // an unfinished subtree must not be reported
+			}
 
-		return true;
+			auto& root = roots[directory.root];
+			root.bytes += bytes;
+			root.entries += entries;
+			root.pending += subdirectories.size();
+			if (root.pending.fetch_sub(1) == 1) {
+				finish(root);
+			}
+		});
+
+		loader->running = false;
 	}
-	void FileDialog::m_parseFilter(const std::string& filter)
-	{
-		m_filter = "";
-		m_filterExtensions.clear();
-		m_filterSelection = 0;
 
-		if (filter.empty()) {
+	void FileDialog::m_syncFolderSizes()
+	{
+		if (!m_folderSizeLoader) {
 			return;
 		}
 
-		std::vector<std::string> exts;
+		// read the flag before draining so the last folders can't be missed
+		const bool finished = !m_folderSizeLoader->running;
 
-		size_t lastSplit = 0, lastExt = 0;
-		bool inExtList = false;
-		for (size_t i = 0; i < filter.size(); i++) {
-			if (filter[i] == ',') {
-				if (!inExtList) {
-					lastSplit = i + 1;
-				} else {
-					exts.push_back(filter.substr(lastExt, i - lastExt));
-					lastExt = i + 1;
-				}
+		std::vector<std::pair<uint32_t, FolderSize>> pending;
+		{
+			std::lock_guard<std::mutex> lock{m_folderSizeLoader->mutex};
+			std::swap(pending, m_folderSizeLoader->pending);
+		}
+
+		std::vector<uint32_t> moved;
+		for (const auto& [index, size] : pending) {
+			m_contentFolderSizes[index] = size;
+			m_folderSizeTotal.bytes += size.bytes;
+			m_folderSizeTotal.entries += size.entries;
+			m_folderSizesDone++;
+			if (index < m_displayTextOffsets.size()) {
+				m_displayTextOffsets[index] = NO_DISPLAY_TEXT;
 			}
-			else if (filter[i] == '{') {
-				std::string filterName = filter.substr(lastSplit, i - lastSplit);
-				if (filterName == ".*") {
-					m_filter += std::string(std::string(__("All Files (*.*)\0")).c_str(), 16);
-					m_filterExtensions.push_back(std::vector<std::string>());
-				} else {
-					m_filter += std::string((filterName + "\0").c_str(), filterName.size() + 1);
-				}
+			moved.push_back(index);
+		}
 
-				inExtList = true;
-				lastExt = i + 1;
-			} else if (filter[i] == '}') {
-				exts.push_back(filter.substr(lastExt, i - lastExt));
-				m_filterExtensions.push_back(exts);
-				exts.clear();
+		if (!moved.empty() && std::any_of(m_sortSpecs.begin(), m_sortSpecs.end(), [](const SortSpec& spec) { return spec.column == SortColumn::size; })) {
+			m_reorderContent(std::move(moved));
+			m_updateView(true);
+		}
 
-				inExtList = false;
-			}
+		if (finished) {
+			m_folderSizeLoader.reset();
 		}
+	}
 
-		if (lastSplit != 0) {
-			std::string filterName = filter.substr(lastSplit);
-			if (filterName == ".*") {
-				m_filter += std::string(std::string(__("All Files (*.*)\0")).c_str(), 16);
-				m_filterExtensions.push_back(std::vector<std::string>());
-			}
-			else {
-				m_filter += std::string((filterName + "\0").c_str(), filterName.size() + 1);
-			}
+	uint64_t FileDialog::m_entrySize(uint32_t index) const
+	{
+		if (!m_content.isDirectory(index)) {
+			return m_content.sizes[index];
 		}
+
+		const auto folderSize = m_contentFolderSizes.find(index);
+		return folderSize != m_contentFolderSizes.end() ? folderSize->second.bytes : 0;
 	}
 
-#ifdef __linux__
-	std::filesystem::path FileDialog::m_locateIcon(const std::string& iconName, int size)
+	void FileDialog::m_startWatch()
 	{
-		const auto home = g_get_home_dir();
-		const auto theme = getIconTheme();
-		if (theme.empty()) {
-			fprintf(stderr, "Error getting icon theme\n");
-			return {};
+		m_stopWatch();
+
+		const auto directory = m_content.directory;
+		m_watchStamp = m_callFileSystem(directory, FILE_STAT_TIMEOUT, [directory]() { return DirectoryStamp{directory}; }).value_or(DirectoryStamp{});
+		m_watchPolled = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+		m_watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_watchFd >= 0) {
+			const int fd = m_watchFd;
+			const auto added = m_callFileSystem(directory, FILE_STAT_TIMEOUT, [fd, directory]() {
+				const auto mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+				return inotify_add_watch(fd, directory.c_str(), mask);
+			});
+
+			if (!added) {
+				// still stuck with the descriptor, closing it could hand its number to someone else first
+				m_watchFd = -1;
+			} else if (*added < 0) {
+				// out of watches (or not a local file system), m_syncWatch polls instead
+				::close(m_watchFd);
+				m_watchFd = -1;
+			}
 		}
+#endif
+	}
 
-		if (!m_iconPathCache.contains(theme)) {
-			m_iconPathCache.emplace(std::make_pair(theme, std::unordered_map<std::string, std::filesystem::path>{}));
-		} else if (m_iconPathCache[theme].contains(iconName)) {
-			return m_iconPathCache[theme][iconName];
+	void FileDialog::m_stopWatch()
+	{
+#ifdef __linux__
+		if (m_watchFd >= 0) {
+			::close(m_watchFd);
+			m_watchFd = -1;
 		}
+#endif
+	}
 
-		std::string sizeString = std::to_string(size);
-		std::filesystem::path dimension = sizeString + "x" + sizeString;
-		std::array<std::filesystem::path, NUM_SYSTEM_ICON_PATH> directories{
-			std::filesystem::path{USER_ICON_PATH} / theme / dimension,
-			std::filesystem::path{GLOBAL_ICON_PATH} / theme / dimension,
-		};
+	void FileDialog::m_syncWatch()
+	{
+		// events that arrive while loading stay queued and are applied once the listing is complete
+		if (m_contentLoading || m_content.directory.empty()) {
+			return;
+		}
 
-		for (const auto dir : directories) {
-			std::vector<std::filesystem::path> subdirectories;
-			if (std::filesystem::exists(dir)) {
-				for (const auto subdir : std::filesystem::directory_iterator(dir)) {
-					std::filesystem::path iconPath = subdir / std::filesystem::path{iconName + ".png"};
-					if (std::filesystem::exists(iconPath)) {
-						m_iconPathCache[theme].emplace(std::make_pair(iconName, iconPath));
-						return iconPath;
+#ifdef __linux__
+		if (m_watchFd >= 0) {
+			alignas(struct inotify_event) char buffer[WATCH_BUFFER_SIZE];
+			std::vector<std::string> names;
+			bool overflow = false, gone = false;
+
+			for (ssize_t length = read(m_watchFd, buffer, sizeof(buffer)); length > 0; length = read(m_watchFd, buffer, sizeof(buffer))) {
+				for (char* ptr = buffer; ptr < buffer + length;) {
+					const auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+
+					if (event->mask & IN_Q_OVERFLOW) {
+						overflow = true;
+					} else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+						gone = true;
+					} else if (event->len > 0) {
+						names.emplace_back(event->name);
 					}
+
+					ptr += sizeof(struct inotify_event) + event->len;
 				}
 			}
-		}
 
-		return {};
-	}
+			if (gone) {
+				// the polling below empties the listing once the directory can't be read anymore
+				m_stopWatch();
+			} else if (overflow) {
+				m_rescanContent(true);
+				return;
+			} else {
+				m_applyChanges(std::move(names));
+				return;
+			}
+		}
 #endif
 
-	void* FileDialog::m_getIcon(const std::filesystem::path& path)
-	{
-		const std::string pathU8 = path.u8string();
+		const auto now = std::chrono::steady_clock::now();
+		if (now - m_watchPolled < WATCH_POLL_INTERVAL || !m_isResponsive(m_content.directory)) {
+			return;
+		}
+		m_watchPolled = now;
 
-		if (m_icons.contains(pathU8)) {
-			return m_icons[pathU8];
+		// taken before reading the directory so nothing that happens meanwhile is missed next time
+		const auto directory = m_content.directory;
+		const auto stamp = m_callFileSystem(directory, FILE_STAT_TIMEOUT, [directory]() { return DirectoryStamp{directory}; });
+		if (!stamp || *stamp == m_watchStamp) {
+			return;
 		}
+		m_watchStamp = *stamp;
 
-#ifdef _WIN32
-		DWORD attrs = 0;
-		UINT flags = SHGFI_ICON | SHGFI_LARGEICON;
-		if (!std::filesystem::exists(path)) {
-			flags |= SHGFI_USEFILEATTRIBUTES;
-			attrs = FILE_ATTRIBUTE_DIRECTORY;
+		m_rescanContent(false);
+	}
+
+	void FileDialog::m_rescanContent(bool everything)
+	{
+		const auto directory = m_content.directory;
+		const auto listed = m_callFileSystem(directory, FILE_LIST_TIMEOUT, [directory]() { return listNames(directory); });
+		if (!listed) {
+			return; // the next poll after a retry tries again
 		}
+		const auto& present = *listed;
 
-		SHFILEINFOW fileInfo = { 0 };
-		std::wstring pathW = path.wstring();
-		for (int i = 0; i < pathW.size(); i++) {
-			if (pathW[i] == '/') {
-				pathW[i] = '\\';
+		// only names that came or went, unless we lost track of modifications too
+		std::vector<std::string> names;
+		for (uint32_t i = 0; i < m_content.size(); i++) {
+			if (!m_isRemoved(i) && (everything || !present.contains(std::string{m_content.name(i)}))) {
+				names.emplace_back(m_content.name(i));
 			}
 		}
-		SHGetFileInfoW(pathW.c_str(), attrs, &fileInfo, sizeof(SHFILEINFOW), flags);
 
-		if (fileInfo.hIcon == nullptr) {
-			return nullptr;
+		for (const auto& name : present) {
+			if (m_findEntry(name) < 0) {
+				names.push_back(name);
+			}
 		}
 
-		ICONINFO iconInfo = { 0 };
-		GetIconInfo(fileInfo.hIcon, &iconInfo);
-		
-		if (iconInfo.hbmColor == nullptr) {
-			return nullptr;
-		}
+		m_applyChanges(std::move(names));
+	}
 
-		DIBSECTION ds;
-		GetObject(iconInfo.hbmColor, sizeof(ds), &ds);
-		int byteSize = ds.dsBm.bmWidth * ds.dsBm.bmHeight * (ds.dsBm.bmBitsPixel / 8);
+	int64_t FileDialog::m_findEntry(std::string_view name)
+	{
+		if (m_contentNameIndex.empty()) {
+			m_contentNameIndex.reserve(m_content.size());
+			for (uint32_t i = 0; i < m_content.size(); i++) {
+				if (!m_isRemoved(i)) {
+					m_contentNameIndex.emplace(std::hash<std::string_view>{}(m_content.name(i)), i);
+				}
+			}
+		}
 
-		if (byteSize == 0) {
-			return nullptr;
+		const auto [first, last] = m_contentNameIndex.equal_range(std::hash<std::string_view>{}(name));
+		for (auto it = first; it != last; ++it) {
+			if (m_content.name(it->second) == name) {
+				return it->second;
+			}
 		}
 
-		std::vector<uint8_t> bitmap;
-		bitmap.reserve(byteSize);
-		GetBitmapBits(iconInfo.hbmColor, byteSize, bitmap.data());
+		return -1;
+	}
 
-		m_icons[pathU8] = this->createTexture(bitmap.data(), ds.dsBm.bmWidth, ds.dsBm.bmHeight, Format::BGRA);
+	bool FileDialog::m_isRemoved(uint32_t index) const
+	{
+		return index < m_contentRemoved.size() && m_contentRemoved[index];
+	}
 
-#elif defined(__linux__)
-		GFile* gFile;
-		if (std::filesystem::exists(path)) {
-			gFile = g_file_new_for_path(pathU8.c_str());
-		} else {
-			// treat non-exists path as a director, such as "Quick access"
-			gFile = g_file_new_for_path("/");
+	void FileDialog::m_applyChanges(std::vector<std::string> names)
+	{
+		std::sort(names.begin(), names.end());
+		names.erase(std::unique(names.begin(), names.end()), names.end());
+		names.erase(std::remove_if(names.begin(), names.end(), [](const std::string& name) {
+			return name.find('/') != std::string::npos || name.find('\\') != std::string::npos;
+		}), names.end());
+
+		// called every frame while watching, a quiet one doesn't go to a file worker
+		if (names.empty()) {
+			return;
 		}
 
-		if (!G_IS_OBJECT(gFile)) {
-			return nullptr;
-		}
-		
-		const auto gFileInfo = g_file_query_info(gFile, G_FILE_ATTRIBUTE_STANDARD_ICON, G_FILE_QUERY_INFO_NONE, nullptr, nullptr);
-		if (!G_IS_OBJECT(gFileInfo)) {
-			g_object_unref(gFile);
-			return nullptr;
+		// Quick Access, This PC and listings still being read are simply read again
+		if (m_contentLoading || m_content.directory.empty()) {
+			invalidateListingCache(m_currentDirectory.u8string());
+			m_setDirectory(m_currentDirectory, false);
+			return;
 		}
 
-		const auto icon = g_file_info_get_icon(gFileInfo);
-		if (!G_IS_OBJECT(icon)) {
-			g_object_unref(gFileInfo);
-			g_object_unref(gFile);
-			return nullptr;
+		// read in one go on a file worker, nothing changes if the directory doesn't answer
+		struct Attributes {
+			bool exists, isDirectory;
+			size_t size;
+			time_t dateModified, dateCreated;
+		};
+		const auto directory = m_content.directory;
+		const auto attributes = m_callFileSystem(directory, FILE_LIST_TIMEOUT, [directory, names]() {
+			std::vector<Attributes> attributes(names.size());
+			for (size_t i = 0; i < names.size(); i++) {
+				auto& entry = attributes[i];
+				entry.exists = readAttributes(directory / std::filesystem::u8path(names[i]), entry.isDirectory, entry.size, entry.dateModified, entry.dateCreated);
+			}
+			return attributes;
+		});
+		if (!attributes) {
+			return;
 		}
 
-		std::filesystem::path iconPath{};
-		if (G_IS_THEMED_ICON(icon)) {
-			const auto names = g_themed_icon_get_names(G_THEMED_ICON(icon));
-			for (int i = 0; names[i] != NULL; i++) {
-				iconPath = m_locateIcon(names[i], DEFAULT_ICON_SIZE);
-				if (!iconPath.empty()) {
-					break;
+		// Every name is looked up again rather than trusting the event, so a burst of create/delete/rename
+		// events for one name collapses into whatever is there now. Entries keep their index, removed ones
+		// become tombstones, so selection, previews and cached text of the others stay valid.
+		std::vector<uint32_t> moved; // new entries and entries whose sort position may have changed
+		bool removed = false, selectionChanged = false;
+		for (size_t i = 0; i < names.size(); i++) {
+			const auto& name = names[i];
+			const auto [exists, isDir, size, dateModified, dateCreated] = (*attributes)[i];
+			const int64_t found = m_findEntry(name);
+
+			if (found < 0) {
+				if (exists) {
+					const auto index = static_cast<uint32_t>(m_content.size());
+					m_content.add(name, isDir, size, dateModified, dateCreated);
+					m_contentNameIndex.emplace(std::hash<std::string_view>{}(name), index);
+					moved.push_back(index);
 				}
+				continue;
 			}
-		} else if (G_IS_FILE_ICON(icon)) {
-			GFile *file_icon = g_file_icon_get_file(G_FILE_ICON(icon));
-			iconPath = g_file_get_path(file_icon);
-		}
 
-		if (iconPath.empty()) {
-			m_loadDefaultIcon(path, pathU8);
-		} else {
+			// not every file system (or stat call) has a birth time, an unknown one doesn't count as a change
+			const auto index = static_cast<uint32_t>(found);
+			const bool sameCreated = dateCreated == 0 || m_content.datesCreated[index] == 0 || dateCreated == m_content.datesCreated[index];
+			if (exists && isDir == m_content.isDirectory(index) && size == m_content.sizes[index] &&
+				dateModified == m_content.datesModified[index] && sameCreated) {
+				continue;
+			}
 
-			int width, height, channel;
-			const auto image_data = stbi_load(iconPath.string().c_str(), &width, &height, &channel, 0);
-			m_icons[pathU8] = this->createTexture(image_data, width, height, Format::RGBA);
-		}
+			// the preview, the folder size and the formatted text are out of date either way
+			m_contentFolderSizes.erase(index);
+			if (auto preview = m_iconPreviews.find(index); preview != m_iconPreviews.end()) {
+				if (preview->second.texture != nullptr) {
+					this->deleteTexture(preview->second.texture);
+				}
+				m_iconPreviews.erase(preview);
+			}
+			if (index < m_displayTextOffsets.size()) {
+				m_displayTextOffsets[index] = NO_DISPLAY_TEXT;
+			}
 
-		g_object_unref(gFileInfo);
-		g_object_unref(gFile);
-#elif defined(__APPLE__)
-		NSImage *icon = nullptr;
+			if (exists) {
+				// a file replaced by a directory of the same name (or the other way round) changes its type too
+				m_content.setDirectory(index, isDir);
+				m_content.sizes[index] = isDir ? 0 : size;
+				m_content.datesModified[index] = dateModified;
+				if (dateCreated != 0) {
+					m_content.datesCreated[index] = dateCreated;
+				}
+				moved.push_back(index);
 
-		if (std::filesystem::exists(path)) {
-			icon = [[NSWorkspace sharedWorkspace] iconForFile:[NSString stringWithUTF8String:path.u8string().c_str()]];
-		} else {
-      		icon = [[NSWorkspace sharedWorkspace] iconForFile:@"/bin"];
+				if (m_isSelected(index) && !m_isSelectable(index)) {
+					m_setSelected(index, false);
+					selectionChanged = true;
+				}
+			} else {
+				m_contentRemoved.resize(m_content.size());
+				m_contentRemoved[index] = true;
+				removed = true;
+
+				const auto [first, last] = m_contentNameIndex.equal_range(std::hash<std::string_view>{}(name));
+				for (auto it = first; it != last; ++it) {
+					if (it->second == index) {
+						m_contentNameIndex.erase(it);
+						break;
+					}
+				}
+
+				if (m_isSelected(index)) {
+					m_setSelected(index, false);
+					selectionChanged = true;
+				}
+				if (m_selectedFileItem == static_cast<int>(index)) {
+					m_selectedFileItem = -1;
+				}
+			}
 		}
 
-		if (icon == nullptr) {
-			return nullptr;
+		if (moved.empty() && !removed) {
+			return;
 		}
 
-		CGImageRef cgImage = [icon CGImageForProposedRect:nullptr context:nullptr hints:nullptr];
-		CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-		auto width = CGImageGetWidth(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL;
-    	auto height = CGImageGetHeight(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL;
-		// use alloc to ensure all initialized to zero
-		std::unique_ptr<uint8_t> rawData{reinterpret_cast<uint8_t*>(calloc(width * height * DEFAULT_ICON_CHANNELS, sizeof(uint8_t)))};
-		CGContextRef bitmapContext = CGBitmapContextCreate(rawData.get(), 
-														   width, 
-														   height, 
-														   CGImageGetBitsPerComponent(cgImage), 
-														   CGImageGetBytesPerRow(cgImage) * APPLE_ICON_DEFAULT_SCALE_LEVEL, 
-														   colorSpace, 
-														   CGImageGetAlphaInfo(cgImage));
-		
-		if (bitmapContext == nullptr) {
-			CGImageRelease(cgImage);
-			CGColorSpaceRelease(colorSpace);
-			return nullptr;
+		m_reorderContent(std::move(moved));
+		m_updateView(true);
+
+		if (selectionChanged) {
+			m_updateSelectionText();
 		}
 
-		CGContextScaleCTM(bitmapContext, APPLE_ICON_DEFAULT_SCALE_LEVEL, APPLE_ICON_DEFAULT_SCALE_LEVEL);
-		CGContextDrawImage(bitmapContext, CGRectMake(0, 0, width / APPLE_ICON_DEFAULT_SCALE_LEVEL, height / APPLE_ICON_DEFAULT_SCALE_LEVEL), cgImage);
+		// the cached copy doesn't know about the change, the next visit reads the directory again
+		m_eraseListing(m_contentListingKey);
 
-		m_icons[pathU8] = this->createTexture(reinterpret_cast<const uint8_t*>(rawData.get()), width, height, Format::RGBA);
+		// previews for new images, unless the loader is still busy with the old snapshot
+		if (m_previewLoader && !m_previewLoader->running) {
+			m_syncPreview(); // what it decoded before letting it go
+			m_previewLoader.reset();
+			m_refreshIconPreview();
+		}
 
-		CGImageRelease(cgImage);
-		CGColorSpaceRelease(colorSpace);
-		CGContextRelease(bitmapContext);
-#else
-		m_loadDefaultIcon(path, pathU8);
-#endif
-		return m_icons[pathU8];
+		m_startFolderSizes();
 	}
 
-	void FileDialog::m_loadDefaultIcon(const std::filesystem::path& path, const std::string& pathU8)
+	void FileDialog::m_reorderContent(std::vector<uint32_t> moved)
 	{
-		auto icon = DEFAULT_FILE_ICON;
-		if (std::filesystem::is_directory(path) || !std::filesystem::exists(path)) {
-			// treat non-exists path as a director, such as "Quick access"
-			icon = DEFAULT_FOLDER_ICON;
+		// take the changed entries out of the order and merge them back in at their sorted positions
+		std::vector<uint8_t> isMoved(m_content.size(), false);
+		for (uint32_t index : moved) {
+			isMoved[index] = true;
 		}
+		std::erase_if(m_order, [this, &isMoved](uint32_t index) {
+			return isMoved[index] || m_isRemoved(index);
+		});
 
-		ImVec4 wndBg = ImGui::GetStyleColorVec4(ImGuiCol_WindowBg);
+		const auto compareFn = [this](uint32_t left, uint32_t right) -> bool {
+			return m_compareContent(left, right);
+		};
+		std::sort(moved.begin(), moved.end(), compareFn);
 
-		// light theme - load default icons
-		if (ImGui::GetStyleColorVec4(ImGuiCol_WindowBg) == IMGUI_LIGHT_THEME_WINDOW_BG) {
-			m_icons[pathU8] = this->createTexture(reinterpret_cast<const uint8_t*>(icon.data()), DEFAULT_ICON_SIZE, DEFAULT_ICON_SIZE, Format::BGRA);
-		}
-		// dark theme - invert the colors
-		else {
-			std::vector<uint32_t> invertedIcon;
-			invertedIcon.reserve(DEFAULT_ICON_SIZE * DEFAULT_ICON_SIZE * DEFAULT_ICON_CHANNELS);
-			std::transform(icon.cbegin(), icon.cend(), invertedIcon.begin(), [](auto rgba){
-				return (RGB_MASK - (rgba & RGB_MASK)) | (rgba & ALPHA_MASK);
-			});
+		std::vector<uint32_t> order;
+		order.reserve(m_order.size() + moved.size());
+		std::merge(m_order.begin(), m_order.end(), moved.begin(), moved.end(), std::back_inserter(order), compareFn);
+		m_order = std::move(order);
 
-			m_icons[pathU8] = this->createTexture(reinterpret_cast<const uint8_t*>(invertedIcon.data()), DEFAULT_ICON_SIZE, DEFAULT_ICON_SIZE, Format::BGRA);
+		m_orderRank.resize(m_content.size());
+		for (uint32_t i = 0; i < m_order.size(); i++) {
+			m_orderRank[m_order[i]] = i;
 		}
 	}
 
-	void FileDialog::m_clearIcons()
+	bool FileDialog::m_matchesFilter(uint32_t index) const
 	{
-		std::vector<unsigned int> deletedIcons;
+		const bool isDirectory = m_content.isDirectory(index);
 
-		// delete textures
-		for (auto& icon : m_icons) {
-			unsigned int ptr = (unsigned int)((uintptr_t)icon.second);
-
-			if (std::count(deletedIcons.begin(), deletedIcons.end(), ptr)) { // skip duplicates
-				continue;
-			}
+		// skip files when IFD_DIALOG_DIRECTORY
+		if (!isDirectory && m_type == DialogType::openDirectory) {
+			return false;
+		}
 
-			deletedIcons.push_back(ptr);
-			deleteTexture(icon.second);
+		// check if extension matches, on the folded name and type key the listing has anyway
+		if (!isDirectory && m_type != DialogType::openDirectory && m_filterSelection < m_filters.size()) {
+			return m_filters[m_filterSelection].matches(m_content.searchKeys[index], m_content.typeKey(index));
 		}
 
-		m_icons.clear();
+		return true;
 	}
 
-	void FileDialog::m_refreshIconPreview()
+	int FileDialog::m_matchQuery(uint32_t index) const
 	{
-		if (m_zoom >= ZOOM_LEVEL_RENDER_PREVIEW) {
-			if (!m_previewLoader.joinable()) {
-				m_previewLoaderRunning = true;
-				m_previewLoader = std::thread(&FileDialog::m_loadPreview, this);
-			}
-		} else {
-			m_clearIconPreview();
+		if ((m_viewQueryMask & ~m_content.searchMasks[index]) != 0) {
+			return NO_MATCH;
 		}
+
+		return fuzzyMatch(m_content.searchKeys[index], m_viewQuery);
 	}
 
-	void FileDialog::m_clearIconPreview()
+	void FileDialog::m_updateView(bool rebuild)
 	{
-		m_stopPreviewLoader();
+		std::string previousQuery = std::move(m_viewQuery);
+		m_viewQuery = foldCase(m_searchBuffer);
+		m_viewQueryMask = characterMask(m_viewQuery);
+
+		// a query that extends the previous one can only match a subset of the previous matches
+		std::vector<std::pair<int, uint32_t>> matches;
+		const auto test = [this, &matches](uint32_t index) {
+			int score = m_matchQuery(index);
+			if (score != NO_MATCH) {
+				matches.emplace_back(score, index);
+			}
+		};
 
-		for (auto& data : m_content) {
-			if (!data.hasIconPreview) {
-				continue;
+		if (!rebuild && m_viewQuery.starts_with(previousQuery)) {
+			for (uint32_t index : m_view) {
+				test(index);
+			}
+		} else {
+			for (uint32_t index : m_order) {
+				if (m_matchesFilter(index)) {
+					test(index);
+				}
 			}
+		}
 
-			data.hasIconPreview = false;
-			this->deleteTexture(data.iconPreview);
+		// best hits first, ties keep the column order
+		if (!m_viewQuery.empty()) {
+			std::sort(matches.begin(), matches.end(), [this](const auto& left, const auto& right) {
+				return left.first != right.first ? left.first > right.first : m_orderRank[left.second] < m_orderRank[right.second];
+			});
+		}
 
-			if (data.iconPreviewData != nullptr) {
-				stbi_image_free(data.iconPreviewData);
-				data.iconPreviewData = nullptr;
-			}
+		m_view.clear();
+		for (const auto& match : matches) {
+			m_view.push_back(match.second);
 		}
 	}
 
-	void FileDialog::m_stopPreviewLoader()
+	const FileDialog::Listing* FileDialog::m_findListing(const std::string& key, const DirectoryStamp& stamp)
 	{
-		m_previewLoaderRunning = false;
+		auto it = m_listingCacheIndex.find(key);
+		if (it == m_listingCacheIndex.end()) {
+			return nullptr;
+		}
 
-		if (m_previewLoader.joinable()) {
-			m_previewLoader.join();
+		// the directory changed (or is gone) since it was read
+		if (!stamp.valid || !(it->second->stamp == stamp)) {
+			m_eraseListing(key);
+			return nullptr;
 		}
+
+		m_listingCache.splice(m_listingCache.begin(), m_listingCache, it->second);
+		return &it->second->content;
 	}
 
-	void FileDialog::m_loadPreview()
+	void FileDialog::m_storeListing(const std::string& key, const DirectoryStamp& stamp, Listing&& content)
 	{
-		for (size_t i = 0; m_previewLoaderRunning && i < m_content.size(); i++) {
-			auto& data = m_content[i];
-
-			if (data.hasIconPreview) {
-				continue;
-			}
+		if (key.empty() || !stamp.valid) {
+			return;
+		}
 
-			if (data.path.has_extension()) {
-				std::string ext = data.path.extension().u8string();
-				if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga") {
-					int width, height, nrChannels;
-					unsigned char* image = stbi_load(data.path.u8string().c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+		m_eraseListing(key);
 
-					if (image == nullptr || width == 0 || height == 0) {
-						continue;
-					}
+		const size_t bytes = sizeof(ListingCacheEntry) + key.size() + content.memoryUsage();
 
-					data.hasIconPreview = true;
-					data.iconPreviewData = image;
-					data.iconPreviewWidth = width;
-					data.iconPreviewHeight = height;
-				}
-			}
-		}
+		m_listingCacheEntries += content.size();
+		m_listingCacheBytes += bytes;
+		m_listingCache.push_front(ListingCacheEntry{key, stamp, std::move(content), bytes});
+		m_listingCacheIndex[key] = m_listingCache.begin();
 
-		m_previewLoaderRunning = false;
+		m_trimListingCache();
 	}
 
-	void FileDialog::m_setDirectory(const std::filesystem::path& p, bool addHistory)
+	void FileDialog::m_eraseListing(const std::string& key)
 	{
-		bool isSameDir = m_currentDirectory == p;
-
-		if (addHistory && !isSameDir) {
-			m_backHistory.push(m_currentDirectory);
+		auto it = m_listingCacheIndex.find(key);
+		if (it == m_listingCacheIndex.end()) {
+			return;
 		}
 
-		m_currentDirectory = p;
-#ifdef _WIN32
-		// drives don't work well without the backslash symbol
-		if (p.u8string().size() == 2 && p.u8string()[1] == ':') {
-			m_currentDirectory = std::filesystem::u8path(p.u8string() + "\\");
-		}
-#endif
+		m_listingCacheEntries -= it->second->content.size();
+		m_listingCacheBytes -= it->second->bytes;
+		m_listingCache.erase(it->second);
+		m_listingCacheIndex.erase(it);
+	}
 
-		m_clearIconPreview();
-		m_content.clear(); // p == "" after this line, due to reference
-		m_selectedFileItem = -1;
-		
-		if (m_type == DialogType::openDirectory || m_type == DialogType::openFile) {
-			m_inputTextbox = "";
+	void FileDialog::m_trimListingCache()
+	{
+		while (!m_listingCache.empty() && (m_listingCacheEntries > m_listingCacheMaxEntries || m_listingCacheBytes > m_listingCacheMaxBytes)) {
+			m_eraseListing(m_listingCache.back().key);
 		}
+	}
 
-		m_selections.clear();
-
-		if (!isSameDir) {
-			m_searchBuffer.clear();
-			m_clearIcons();
+	bool FileDialog::m_compareContent(uint32_t left, uint32_t right) const
+	{
+		// directories first, then the keys built with the listing; later specs only break ties
+		if (m_content.isDirectory(left) != m_content.isDirectory(right)) {
+			return m_content.isDirectory(left);
 		}
 
-		if (p.u8string() == "Quick Access") {
-			for (auto& node : m_treeCache) {
-				if (node->path == p) {
-					for (auto& c : node->children) {
-						m_content.push_back(FileData(c->path));
-					}
-				}
+		for (const auto& spec : m_sortSpecs) {
+			int comp = 0;
+
+			switch (spec.column) {
+			case SortColumn::name:
+				comp = m_content.sortKeys[left].compare(m_content.sortKeys[right]);
+				break;
+			case SortColumn::date:
+				comp = (m_content.datesModified[left] > m_content.datesModified[right]) - (m_content.datesModified[left] < m_content.datesModified[right]);
+				break;
+			case SortColumn::size:
+				comp = (m_entrySize(left) > m_entrySize(right)) - (m_entrySize(left) < m_entrySize(right));
+				break;
+			case SortColumn::type:
+				comp = m_content.typeKey(left).compare(m_content.typeKey(right));
+				break;
 			}
-		} else if (p.u8string() == "This PC") {
-			for (auto& node : m_treeCache) {
-				if (node->path == p) {
-					for (auto& c : node->children) {
-						m_content.push_back(FileData(c->path));
-					}
-				}
+
+			if (comp != 0) {
+				return spec.direction == ImGuiSortDirection_Ascending ? comp < 0 : comp > 0;
 			}
-		} else {
-			std::error_code ec;
-			if (std::filesystem::exists(m_currentDirectory, ec)) {
-				for (const auto& entry : std::filesystem::directory_iterator(m_currentDirectory, ec)) {
-					FileData info(entry.path());
+		}
 
-					// skip files when IFD_DIALOG_DIRECTORY
-					if (!info.isDirectory && m_type == DialogType::openDirectory) {
-						continue;
-					}
+		const int comp = m_content.sortKeys[left].compare(m_content.sortKeys[right]);
+		return comp != 0 ? comp < 0 : left < right;
+	}
 
-					// check if filename matches search query
-					if (!m_searchBuffer.empty()) {
-						std::string filename = info.path.u8string();
+	void FileDialog::m_sortContent()
+	{
+		// only the indices move, the entries stay where the loader put them
+		m_order.clear();
+		for (uint32_t i = 0; i < m_content.size(); i++) {
+			if (!m_isRemoved(i)) {
+				m_order.push_back(i);
+			}
+		}
 
-						std::string filenameSearch = filename;
-						std::string query = m_searchBuffer;
-						std::transform(filenameSearch.begin(), filenameSearch.end(), filenameSearch.begin(), ::tolower);
-						std::transform(query.begin(), query.end(), query.begin(), ::tolower);
+		// split into directories and files
+		auto fileStart = std::stable_partition(m_order.begin(), m_order.end(), [this](uint32_t index) {
+			return m_content.isDirectory(index);
+		});
 
-						if (filenameSearch.find(query, 0) == std::string::npos) {
-							continue;
-						}
-					}
+		auto compareFn = [this](uint32_t left, uint32_t right) -> bool {
+			return m_compareContent(left, right);
+		};
 
-					// check if extension matches
-					if (!info.isDirectory && m_type != DialogType::openDirectory) {
-						if (m_filterSelection < m_filterExtensions.size()) {
-							const auto& exts = m_filterExtensions[m_filterSelection];
+		const size_t threadCount = m_sortThreads != 0 ? m_sortThreads : std::max<size_t>(1, std::thread::hardware_concurrency());
 
-							if (exts.size() > 0) {
-								std::string extension = info.path.extension().u8string();
+		// sort the directories
+		parallelSort(m_order.begin(), fileStart, compareFn, threadCount);
 
-								// extension not found? skip
-								if (std::count(exts.begin(), exts.end(), extension) == 0) {
-									continue;
-								}
-							}
-						}
-					}
+		// sort the files
+		parallelSort(fileStart, m_order.end(), compareFn, threadCount);
 
-					m_content.push_back(info);
-				}
-			}
+		m_orderRank.resize(m_content.size());
+		for (uint32_t i = 0; i < m_order.size(); i++) {
+			m_orderRank[m_order[i]] = i;
 		}
 
-		m_sortContent(m_sortColumn, m_sortDirection);
-		m_refreshIconPreview();
+		m_updateView(true);
 	}
 
-	void FileDialog::m_sortContent(unsigned int column, unsigned int sortDirection)
+	std::pair<const char*, const char*> FileDialog::m_getDisplayText(uint32_t index)
 	{
-		// 0 -> name, 1 -> date, 2 -> size
-		m_sortColumn = column;
-		m_sortDirection = sortDirection;
+		if (index >= m_displayTextOffsets.size()) {
+			m_displayTextOffsets.resize(m_content.size(), NO_DISPLAY_TEXT);
+		}
 
-		// split into directories and files
-		std::partition(m_content.begin(), m_content.end(), [](const FileData& data) {
-			return data.isDirectory;
-		});
+		if (m_displayTextOffsets[index] == NO_DISPLAY_TEXT) {
+			m_displayTextOffsets[index] = static_cast<uint32_t>(m_displayText.size());
 
-		if (m_content.size() > 0) {
-			// find where the file list starts
-			size_t fileIndex = 0;
-			for (; fileIndex < m_content.size(); fileIndex++) {
-				if (!m_content[fileIndex].isDirectory) {
-					break;
-				}
+			char buffer[64];
+			struct tm tm;
+#ifdef _WIN32
+			const bool hasTime = localtime_s(&tm, &m_content.datesModified[index]) == 0;
+#else
+			const bool hasTime = localtime_r(&m_content.datesModified[index], &tm) != nullptr;
+#endif
+			if (hasTime) {
+				snprintf(buffer, sizeof(buffer), "%d/%d/%d %02d:%02d", tm.tm_mon + 1, tm.tm_mday, 1900 + tm.tm_year, tm.tm_hour, tm.tm_min);
+			} else {
+				snprintf(buffer, sizeof(buffer), "---");
 			}
+			m_displayText.append(buffer);
+			m_displayText.push_back('\0');
+
+			if (!m_content.isDirectory(index)) {
+				SmartSize size{m_content.sizes[index]};
+				snprintf(buffer, sizeof(buffer), "%.3f %.*s", size.size, static_cast<int>(size.unit.size()), size.unit.data());
+				m_displayText.append(buffer);
+			} else if (const auto folderSize = m_contentFolderSizes.find(index); folderSize != m_contentFolderSizes.end()) {
+				SmartSize size{folderSize->second.bytes};
+				snprintf(buffer, sizeof(buffer), __("%.3f %.*s, %llu items"), size.size, static_cast<int>(size.unit.size()), size.unit.data(),
+					static_cast<unsigned long long>(folderSize->second.entries));
+				m_displayText.append(buffer);
+			}
+			m_displayText.push_back('\0');
+		}
 
-			// compare function
-			auto compareFn = [column, sortDirection](const FileData& left, const FileData& right) -> bool {
-				// name
-				if (column == 0) {
-					std::string lName = left.path.u8string();
-					std::string rName = right.path.u8string();
-
-					std::transform(lName.begin(), lName.end(), lName.begin(), ::tolower);
-					std::transform(rName.begin(), rName.end(), rName.begin(), ::tolower);
-
-					int comp = lName.compare(rName);
-
-					if (sortDirection == ImGuiSortDirection_Ascending)
-						return comp < 0;
-					return comp > 0;
-				}  else if (column == 1) { // date
-					if (sortDirection == ImGuiSortDirection_Ascending) {
-						return left.dateModified < right.dateModified;
-					} else {
-						return left.dateModified > right.dateModified;
-					}
-				} else if (column == 2) { // size
-					if (sortDirection == ImGuiSortDirection_Ascending) {
-						return left.size < right.size;
-					} else {
-						return left.size > right.size;
-					}
-				}
+		const char* date = m_displayText.c_str() + m_displayTextOffsets[index];
+		return {date, date + strlen(date) + 1};
+	}
 
-				return false;
-			};
+	void FileDialog::m_checkDisplayLocale()
+	{
+		// the numeric locale changes the decimal separator of sizes, the time zone every date
+#ifdef _WIN32
+		_tzset();
+		std::string displayLocale = std::string(_tzname[0]) + _tzname[1] + std::to_string(_timezone);
+#else
+		tzset();
+		std::string displayLocale = std::string(tzname[0]) + tzname[1];
 
-			// sort the directories
-			std::sort(m_content.begin(), m_content.begin() + fileIndex, compareFn);
+		struct tm tm;
+		const time_t reference = 0;
+		if (localtime_r(&reference, &tm) != nullptr) {
+			displayLocale += std::to_string(tm.tm_gmtoff);
+		}
+#endif
+		if (const char* numeric = setlocale(LC_NUMERIC, nullptr)) {
+			displayLocale += numeric;
+		}
 
-			// sort the files
-			std::sort(m_content.begin() + fileIndex, m_content.end(), compareFn);
+		if (displayLocale != m_displayLocale) {
+			m_displayLocale = std::move(displayLocale);
+			m_clearDisplayText();
 		}
 	}
 
+	void FileDialog::m_clearDisplayText()
+	{
+		m_displayText.clear();
+		m_displayTextOffsets.clear();
+	}
+
 	void FileDialog::m_renderTree(FileTreeNode& node)
 	{
 		// directory
-		std::error_code ec;
 		ImGui::PushID(node.path.u8string().c_str());
 		bool isClicked = false;
 		std::string displayName = node.path.stem().u8string();
@@ -1425,19 +5181,30 @@ namespace ifd {
 			displayName = node.path.u8string();
 		}
 
-		if (folderNode(displayName.c_str(), (ImTextureID)m_getIcon(node.path), isClicked)) {
+		const IconImage icon = m_getIcon(node.path);
+		if (folderNode(displayName.c_str(), (ImTextureID)icon.texture, ImVec2(icon.uv0[0], icon.uv0[1]), ImVec2(icon.uv1[0], icon.uv1[1]), isClicked)) {
 			if (!node.read) {
-				// cache children if it's not already cached
-				if (std::filesystem::exists(node.path, ec)) {
-					for (const auto& entry : std::filesystem::directory_iterator(node.path, ec)) {
-
-						if (std::filesystem::is_directory(entry, ec)) {
-							node.children.emplace_back(std::make_unique<FileTreeNode>(entry.path().u8string()));
+				// cache children if it's not already cached, a node on a mount that doesn't answer is tried again after a retry
+				const auto directory = node.path;
+				const auto children = m_callFileSystem(directory, FILE_LIST_TIMEOUT, [directory]() {
+					std::vector<std::string> children;
+					std::error_code ec;
+					if (std::filesystem::exists(directory, ec)) {
+						for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+							if (std::filesystem::is_directory(entry, ec)) {
+								children.push_back(entry.path().u8string());
+							}
 						}
 					}
-				}
+					return children;
+				});
 
-				node.read = true;
+				if (children) {
+					for (const auto& child : *children) {
+						node.children.emplace_back(std::make_unique<FileTreeNode>(child));
+					}
+					node.read = true;
+				}
 			}
 
 			// display children
@@ -1455,19 +5222,74 @@ namespace ifd {
 		ImGui::PopID();
 	}
 
+	void FileDialog::m_retryDirectory()
+	{
+		m_unresponsiveMounts.erase(mountOf(m_currentDirectory));
+		m_setDirectory(m_currentDirectory, false);
+	}
+
+	void FileDialog::m_abandonDirectory()
+	{
+		// whatever is stuck there is left behind, back to where we came from
+		m_resetContent();
+		if (!m_backHistory.empty()) {
+			std::filesystem::path newPath = m_backHistory.top();
+			m_backHistory.pop();
+			m_forwardHistory.push(m_currentDirectory);
+
+			m_setDirectory(newPath, false);
+		}
+	}
+
 	void FileDialog::m_renderContent()
 	{
 		if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
 			m_selectedFileItem = -1;
 		}
 
+		if (m_currentDirectory.is_absolute() && !m_isResponsive(m_currentDirectory)) {
+			ImGui::TextDisabled(__("%s is not responding."), m_currentDirectory.u8string().c_str());
+			ImGui::SameLine();
+			if (ImGui::SmallButton(__("Retry##notResponding"))) {
+				m_retryDirectory();
+			}
+			ImGui::SameLine();
+			if (ImGui::SmallButton(__("Cancel##notResponding"))) {
+				m_abandonDirectory();
+			}
+		} else if (m_contentRevalidating) {
+			ImGui::TextDisabled(__("Checking for changes..."));
+		} else if (m_contentLoading && m_searchingSubfolders) {
+			ImGui::TextDisabled(__("Searching subfolders, %zu found..."), m_content.size());
+		} else if (m_contentLoading) {
+			ImGui::TextDisabled(__("Loading %zu entries..."), m_content.size());
+		} else if (m_folderSizesEnabled && !m_content.directory.empty()) {
+			SmartSize size{m_folderSizeTotal.bytes};
+			if (m_folderSizeLoader) {
+				ImGui::TextDisabled(__("%.3f %.*s in %llu items so far, %zu of %zu folders measured..."), size.size, static_cast<int>(size.unit.size()), size.unit.data(),
+					static_cast<unsigned long long>(m_folderSizeTotal.entries), m_folderSizesDone, m_folderSizesCount);
+			} else {
+				ImGui::TextDisabled(__("%.3f %.*s in %llu items"), size.size, static_cast<int>(size.unit.size()), size.unit.data(),
+					static_cast<unsigned long long>(m_folderSizeTotal.entries));
+			}
+		}
+
+#ifdef __APPLE__
+		if (ImGui::GetIO().KeySuper && ImGui::IsWindowFocused() && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_A))) {
+#else
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsWindowFocused() && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_A))) {
+#endif
+			m_selectAll();
+		}
+
 		// table view
 		if (m_zoom == ZOOM_LEVEL_LIST_VIEW) {
-			if (ImGui::BeginTable("##contentTable", 3, ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable | ImGuiTableFlags_NoBordersInBody, ImVec2(0, -FLT_MIN))) {
-				// header
-				ImGui::TableSetupColumn(__("Name##filename"), ImGuiTableColumnFlags_WidthStretch, 0.0f -1.0f, 0);
-				ImGui::TableSetupColumn(__("Date modified##filedate"), ImGuiTableColumnFlags_WidthStretch, 0.0f, 1);
-				ImGui::TableSetupColumn(__("Size##filesize"), ImGuiTableColumnFlags_WidthStretch, 0.0f, 2);
+			if (ImGui::BeginTable("##contentTable", 4, ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_NoBordersInBody | ImGuiTableFlags_ScrollY, ImVec2(0, -FLT_MIN))) {
+				// header, the user IDs are the SortColumn values
+				ImGui::TableSetupColumn(__("Name##filename"), ImGuiTableColumnFlags_WidthStretch, 0.0f -1.0f, magic_enum::enum_integer(SortColumn::name));
+				ImGui::TableSetupColumn(__("Date modified##filedate"), ImGuiTableColumnFlags_WidthStretch, 0.0f, magic_enum::enum_integer(SortColumn::date));
+				ImGui::TableSetupColumn(__("Type##filetype"), ImGuiTableColumnFlags_WidthStretch, 0.0f, magic_enum::enum_integer(SortColumn::type));
+				ImGui::TableSetupColumn(__("Size##filesize"), ImGuiTableColumnFlags_WidthStretch, 0.0f, magic_enum::enum_integer(SortColumn::size));
                 ImGui::TableSetupScrollFreeze(0, 1);
 				ImGui::TableHeadersRow();
 
@@ -1475,111 +5297,137 @@ namespace ifd {
 				if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs()) {
                     if (sortSpecs->SpecsDirty) {
 						sortSpecs->SpecsDirty = false;
-						m_sortContent(sortSpecs->Specs->ColumnUserID, sortSpecs->Specs->SortDirection);
+
+						m_sortSpecs.clear();
+						for (int i = 0; i < sortSpecs->SpecsCount; i++) {
+							m_sortSpecs.push_back(SortSpec{static_cast<SortColumn>(sortSpecs->Specs[i].ColumnUserID), sortSpecs->Specs[i].SortDirection});
+						}
+						m_sortContent();
                     }
 				}
 
-				// content
-				int fileId = 0;
-				for (auto& entry : m_content) {
-					std::string filename = entry.path.filename().u8string();
-
-					if (filename.size() == 0) {
-						filename = entry.path.u8string(); // drive
-					}
+				m_checkDisplayLocale();
+
+				// content, rows all have the same height so only the visible ones are submitted
+				ImGuiListClipper clipper;
+				clipper.Begin(static_cast<int>(m_view.size()));
+				bool directoryChanged = false;
+				while (!directoryChanged && clipper.Step()) {
+					for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+						const uint32_t fileId = m_view[row];
+						const auto path = m_content.path(fileId);
+						const char* filename = m_content.filename(fileId);
 					
-					bool isSelected = std::count(m_selections.begin(), m_selections.end(), entry.path);
-
-					ImGui::TableNextRow();
-
-					// file name
-					ImGui::TableSetColumnIndex(0);
-					ImGui::Image((ImTextureID)m_getIcon(entry.path), ImVec2(computeIconSize(ImGui::GetFont()->FontSize), computeIconSize(ImGui::GetFont()->FontSize)));
-					ImGui::SameLine();
-
-					if (ImGui::Selectable(filename.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
-						std::error_code ec;
-						bool isDir = std::filesystem::is_directory(entry.path, ec);
-
-						if (ImGui::IsMouseDoubleClicked(0)) {
-							if (isDir) {
-								m_setDirectory(entry.path);
-								break;
+						bool isSelected = m_isSelected(fileId);
+
+						ImGui::TableNextRow();
+
+						// file name
+						ImGui::TableSetColumnIndex(0);
+						const IconImage icon = m_getIcon(path, !m_content.isDirectory(fileId));
+						ImGui::Image((ImTextureID)icon.texture, ImVec2(computeIconSize(ImGui::GetFont()->FontSize), computeIconSize(ImGui::GetFont()->FontSize)), ImVec2(icon.uv0[0], icon.uv0[1]), ImVec2(icon.uv1[0], icon.uv1[1]));
+						ImGui::SameLine();
+
+						if (ImGui::Selectable(filename, isSelected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
+							const bool isDir = m_content.isDirectory(fileId);
+
+							if (ImGui::IsMouseDoubleClicked(0)) {
+								if (isDir) {
+									m_setDirectory(path);
+									directoryChanged = true; // m_view is rebuilt, stop drawing the old one
+									break;
+								} else {
+									m_finalize(filename);
+								}
 							} else {
-								m_finalize(filename);
-							}
-						} else {
-							if ((isDir && m_type == DialogType::openDirectory) || !isDir) {
-								m_select(entry.path, ImGui::GetIO().KeyCtrl);
+								if ((isDir && m_type == DialogType::openDirectory) || !isDir) {
+									m_select(fileId, ImGui::GetIO().KeyCtrl, ImGui::GetIO().KeyShift);
+								}
 							}
 						}
-					}
 
-					if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
-						m_selectedFileItem = fileId;
-					}
+						if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+							m_selectedFileItem = static_cast<int>(fileId);
+						}
 
-					fileId++;
+						// date
+						const auto [dateText, sizeText] = m_getDisplayText(fileId);
+						ImGui::TableSetColumnIndex(1);
+						ImGui::TextUnformatted(dateText);
 
-					// date
-					ImGui::TableSetColumnIndex(1);
-					auto tm = std::localtime(&entry.dateModified);
-					if (tm != nullptr) {
-						ImGui::Text("%d/%d/%d %02d:%02d", tm->tm_mon + 1, tm->tm_mday, 1900 + tm->tm_year, tm->tm_hour, tm->tm_min);
-					} else {
-						ImGui::Text("---");
-					}
+						// type
+						ImGui::TableSetColumnIndex(2);
+						if (m_content.isDirectory(fileId)) {
+							ImGui::TextUnformatted(__("Folder"));
+						} else {
+							const auto type = m_content.typeKey(fileId);
+							ImGui::TextUnformatted(type.data(), type.data() + type.size());
+						}
 
-					// size
-					ImGui::TableSetColumnIndex(2);
-					if (!entry.isDirectory) {
-						ImGui::Text("%.3f %s", entry.size.size, entry.size.unit.c_str());
+						// size
+						ImGui::TableSetColumnIndex(3);
+						ImGui::TextUnformatted(sizeText);
 					}
 				}
+				clipper.End();
 
 				ImGui::EndTable();
 			}
 		} else { // "icon" view
-			// content
-			int fileId = 0;
-			for (auto& entry : m_content) {
-				if (entry.hasIconPreview && entry.iconPreviewData != nullptr) {
-					entry.iconPreview = this->createTexture(entry.iconPreviewData, entry.iconPreviewWidth, entry.iconPreviewHeight, Format::RGBA);
-					stbi_image_free(entry.iconPreviewData);
-					entry.iconPreviewData = nullptr;
-				}
-
-				std::string filename = entry.path.filename().u8string();
-				if (filename.size() == 0) {
-					filename = entry.path.u8string(); // drive
-				}
-
-				bool isSelected = std::count(m_selections.begin(), m_selections.end(), entry.path);
+			m_syncPreview();
+
+			// content, laid out as rows of equally sized cells so only the visible rows are submitted
+			const ImVec2 cellSize{32 + 16 * m_zoom, 32 + 16 * m_zoom};
+			const ImVec2 spacing = ImGui::GetStyle().ItemSpacing;
+			const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + spacing.x) / (cellSize.x + spacing.x)));
+			const int rows = (static_cast<int>(m_view.size()) + columns - 1) / columns;
+
+			ImGuiListClipper clipper;
+			clipper.Begin(rows, cellSize.y + spacing.y);
+			bool directoryChanged = false;
+			while (!directoryChanged && clipper.Step()) {
+				for (int row = clipper.DisplayStart; !directoryChanged && row < clipper.DisplayEnd; row++) {
+					const size_t rowEnd = std::min(m_view.size(), static_cast<size_t>(row + 1) * columns);
+					for (size_t cell = static_cast<size_t>(row) * columns; cell < rowEnd; cell++) {
+						const uint32_t fileId = m_view[cell];
+						const auto path = m_content.path(fileId);
+						const char* filename = m_content.filename(fileId);
+
+						bool isSelected = m_isSelected(fileId);
+
+						const auto preview = m_iconPreviews.find(fileId);
+						const bool hasPreview = preview != m_iconPreviews.end();
+						const IconImage icon = hasPreview ? IconImage{preview->second.texture} : m_getIcon(path, !m_content.isDirectory(fileId));
+
+						if (cell % columns != 0) {
+							ImGui::SameLine();
+						}
 
-				if (fileIcon(filename.c_str(), isSelected, entry.hasIconPreview ? entry.iconPreview : (ImTextureID)m_getIcon(entry.path), ImVec2(32 + 16 * m_zoom, 32 + 16 * m_zoom), entry.hasIconPreview, entry.iconPreviewWidth, entry.iconPreviewHeight)) {
-					std::error_code ec;
-					bool isDir = std::filesystem::is_directory(entry.path, ec);
+						if (fileIcon(filename, isSelected, (ImTextureID)icon.texture, ImVec2(icon.uv0[0], icon.uv0[1]), ImVec2(icon.uv1[0], icon.uv1[1]), cellSize, hasPreview, hasPreview ? preview->second.width : 0, hasPreview ? preview->second.height : 0)) {
+							const bool isDir = m_content.isDirectory(fileId);
 
-					if (ImGui::IsMouseDoubleClicked(0)) {
-						if (isDir) {
-							m_setDirectory(entry.path);
-							break;
-						} else {
-							m_finalize(filename);
+							if (ImGui::IsMouseDoubleClicked(0)) {
+								if (isDir) {
+									m_setDirectory(path);
+									directoryChanged = true; // m_view is rebuilt, stop drawing the old one
+									break;
+								} else {
+									m_finalize(filename);
+								}
+							} else {
+								if ((isDir && m_type == DialogType::openDirectory) || !isDir) {
+									m_select(fileId, ImGui::GetIO().KeyCtrl, ImGui::GetIO().KeyShift);
+								}
+							}
 						}
-					} else {
-						if ((isDir && m_type == DialogType::openDirectory) || !isDir) {
-							m_select(entry.path, ImGui::GetIO().KeyCtrl);
+
+						if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+							m_selectedFileItem = static_cast<int>(fileId);
 						}
 					}
 				}
-
-				if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
-					m_selectedFileItem = fileId;
-				}
-
-				fileId++;
 			}
+			clipper.End();
 		}
 	}
 
@@ -1599,6 +5447,10 @@ namespace ifd {
 				openAreYouSureDlg = true;
 			}
 
+			if (ImGui::Selectable(__("Folder sizes"), m_folderSizesEnabled)) {
+				setFolderSizes(!m_folderSizesEnabled);
+			}
+
 			ImGui::EndPopup();
 		}
 
@@ -1618,12 +5470,14 @@ namespace ifd {
 			if (m_selectedFileItem >= static_cast<int>(m_content.size()) || m_content.size() == 0) {
 				ImGui::CloseCurrentPopup();
 			} else {
-				const FileData& data = m_content[m_selectedFileItem];
-				ImGui::TextWrapped(__("Are you sure you want to delete %s?"), data.path.filename().u8string().c_str());
+				ImGui::TextWrapped(__("Are you sure you want to delete %s?"), m_content.filename(m_selectedFileItem));
 				if (ImGui::Button(__("Yes"))) {
-					std::error_code ec;
-					std::filesystem::remove_all(data.path, ec);
-					m_setDirectory(m_currentDirectory, false); // refresh
+					const auto target = m_content.path(m_selectedFileItem);
+					m_callFileSystem(target, FILE_CHANGE_TIMEOUT, [target]() {
+						std::error_code ec;
+						return std::filesystem::remove_all(target, ec);
+					});
+					m_applyChanges({std::string{m_content.name(m_selectedFileItem)}});
 					ImGui::CloseCurrentPopup();
 				}
 				ImGui::SameLine();
@@ -1640,11 +5494,15 @@ namespace ifd {
 			ImGui::PopItemWidth();
 
 			if (ImGui::Button(__("OK"))) {
-				std::ofstream out((m_currentDirectory / m_newEntryBuffer).string());
-				out << "";
-				out.close();
-
-				m_setDirectory(m_currentDirectory, false); // refresh
+				const auto target = m_currentDirectory / m_newEntryBuffer;
+				m_callFileSystem(target, FILE_CHANGE_TIMEOUT, [target]() {
+					std::ofstream out(target.string());
+					out << "";
+					out.close();
+					return true;
+				});
+
+				m_applyChanges({m_newEntryBuffer});
 				m_newEntryBuffer.clear();
 
 				ImGui::CloseCurrentPopup();
@@ -1662,9 +5520,12 @@ namespace ifd {
 			ImGui::PopItemWidth();
 
 			if (ImGui::Button(__("OK"))) {
-				std::error_code ec;
-				std::filesystem::create_directory(m_currentDirectory / m_newEntryBuffer, ec);
-				m_setDirectory(m_currentDirectory, false); // refresh
+				const auto target = m_currentDirectory / m_newEntryBuffer;
+				m_callFileSystem(target, FILE_CHANGE_TIMEOUT, [target]() {
+					std::error_code ec;
+					return std::filesystem::create_directory(target, ec);
+				});
+				m_applyChanges({m_newEntryBuffer});
 				m_newEntryBuffer.clear();
 				ImGui::CloseCurrentPopup();
 			}
@@ -1679,6 +5540,17 @@ namespace ifd {
 
 	void FileDialog::m_renderFileDialog()
 	{
+		// the only places m_content changes besides m_setDirectory
+		m_syncContent();
+		m_syncWatch();
+		m_syncFolderSizes();
+#ifdef __linux__
+		m_syncIconTheme();
+		m_syncIcons();
+#endif
+		m_syncDefaultIcons();
+		m_syncIconAtlas();
+
 		/***** TOP BAR *****/
 		bool noBackHistory = m_backHistory.empty(), noForwardHistory = m_forwardHistory.empty();
 		
@@ -1741,8 +5613,11 @@ namespace ifd {
 		ImGui::SameLine();
 		ImGui::PopStyleColor();
 
-		if (ImGui::InputTextWithHint("##searchTB", __("Search"), &m_searchBuffer)) {
-			m_setDirectory(m_currentDirectory, false); // refresh
+		bool searchChanged = ImGui::InputTextWithHint("##searchTB", __("Search"), &m_searchBuffer);
+		ImGui::SameLine();
+		searchChanged |= ImGui::Checkbox(__("Subfolders##searchSubfolders"), &m_searchSubfolders);
+		if (searchChanged) {
+			m_search();
 		}
 
 		/***** CONTENT *****/
@@ -1810,7 +5685,8 @@ namespace ifd {
 			int sel = static_cast<int>(m_filterSelection);
 			if (ImGui::Combo("##ext_combo", &sel, m_filter.c_str())) {
 				m_filterSelection = static_cast<size_t>(sel);
-				m_setDirectory(m_currentDirectory, false); // refresh
+				m_clearSelection();
+				m_updateView(true);
 			}
 		}
 
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <list>
 #include <memory>
+#include <optional>
 #include <ctime>
+#include <chrono>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 #include <functional>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm> // std::min, std::max
 
 namespace ifd {
@@ -34,9 +42,13 @@ namespace ifd {
 
 		bool isDone(const std::string& key);
 
-		inline bool hasResult() { return m_result.size(); }
-		inline const std::filesystem::path& getResult() { return m_result[0]; }
-		inline const std::vector<std::filesystem::path>& getResults() { return m_result; }
+		inline bool hasResult() { return m_resultNames.size(); }
+		inline const std::filesystem::path& getResult() { return getResults()[0]; }
+		const std::vector<std::filesystem::path>& getResults(); // builds every path on first call
+
+		// read large multiselections one path at a time instead of through getResults()
+		inline size_t getResultCount() { return m_resultNames.size(); }
+		inline std::filesystem::path getResult(size_t i) { return m_resultDirectory / std::filesystem::u8path(m_resultNames[i]); }
 
 		void close();
 
@@ -50,6 +62,34 @@ namespace ifd {
 		}
 		inline float getZoom() { return m_zoom; }
 
+		// Large listings are sorted on this many threads, 0 (the default) takes one per hardware thread.
+		inline void setSortThreads(size_t count) { m_sortThreads = count; }
+
+		// directory listings are kept in memory and reused until the directory's mtime or inode changes
+		void setListingCacheLimits(size_t maxEntries, size_t maxBytes);
+		void invalidateListingCache(const std::string& path = ""); // empty path drops every listing
+
+		// Listings are also written to files in this directory (e.g. ~/.cache/ImFileDialog), which may be
+		// shared by several runs and processes. A directory found there is shown at once and read again in
+		// the background. Off unless set, an empty path turns it off again.
+		void setListingIndex(const std::string& path, size_t maxBytes = 64 * 1024 * 1024);
+
+		// Folders get the total size and item count of everything below them in the Size column, measured in
+		// the background. Off by default since it reads whole subtrees, also toggled from the context menu.
+		void setFolderSizes(bool enabled);
+		inline bool getFolderSizes() { return m_folderSizesEnabled; }
+
+		// Decoded icons are kept across directories and dialogs, least recently used ones go once either limit
+		// is exceeded. Every icon takes one 66x66 RGBA cell of an atlas texture (about 17 KiB).
+		void setIconCacheLimits(size_t maxIcons, size_t maxBytes);
+		inline uint64_t getIconCacheHits() { return m_iconCacheHits; } // icons found decoded already, in memory or in the icon cache file
+		inline uint64_t getIconCacheMisses() { return m_iconCacheMisses; } // icons that had to be looked up and decoded
+
+		// Theme icons are also kept decoded in this file (e.g. ~/.cache/ImFileDialog/icons), so the next run
+		// shows them without looking them up. Written by close(), read when the icon theme is known and only used
+		// while the theme and its directories are unchanged. Linux only, off unless set, an empty path turns it off.
+		void setIconCacheFile(const std::string& path, size_t maxBytes = 16 * 1024 * 1024);
+
 		std::function<void*(const uint8_t*, int, int, Format)> createTexture;
 		std::function<void(void*)> deleteTexture;
 
@@ -81,32 +121,247 @@ namespace ifd {
 			std::vector<std::unique_ptr<FileTreeNode>> children;
 		};
 
+		// formats a byte count for display, nothing keeps one around
 		struct SmartSize {
-			SmartSize() = default;
 			SmartSize(size_t s);
 
-			auto operator<=>(const SmartSize& others) const noexcept
-			{
-				return sizeInByte <=> others.sizeInByte;
-			}
-
 			size_t sizeInByte;
 			float size;
-			std::string unit;
+			std::string_view unit;
 		};
 
-		struct FileData {
-			FileData(const std::filesystem::path& path);
+		// strings stored back to back in one buffer, each followed by a '\0'
+		struct StringArena {
+			inline size_t size() const { return offsets.size() - 1; }
+			inline const char* c_str(size_t i) const { return data.data() + offsets[i]; }
+			inline std::string_view operator[](size_t i) const { return std::string_view{c_str(i), offsets[i + 1] - offsets[i] - 1}; }
 
-			std::filesystem::path path;
-			bool isDirectory;
-			SmartSize size;
-			time_t dateModified;
+			void push(std::string_view text);
+			void append(const StringArena& others);
+			void clear();
+
+			std::string data;
+			std::vector<uint32_t> offsets{0};
+		};
+
+		// A directory listing as parallel arrays indexed by entry, so an entry costs a few
+		// integers and its strings instead of a path plus several heap blocks.
+		struct Listing {
+			inline size_t size() const { return directoryFlags.size(); }
+			inline bool isDirectory(size_t i) const { return directoryFlags[i] != 0; }
+			inline std::string_view name(size_t i) const { return names[i]; }
+			inline std::string_view typeKey(size_t i) const { const auto key = searchKeys[i]; return key.substr(key.size() - typeKeyLengths[i]); }
+			const char* filename(size_t i) const; // '\0' terminated, the drive or root itself if there's no file name
+			std::filesystem::path path(size_t i) const;
+
+			void add(std::string_view name, bool isDirectory, size_t size, time_t dateModified, time_t dateCreated = 0);
+			void add(const std::filesystem::path& path); // reads the type, size and dates itself
+			void setDirectory(size_t i, bool isDirectory); // also updates the type key
+			void append(const Listing& others);
+			void clear();
+			size_t memoryUsage() const;
+
+			std::filesystem::path directory; // shared by every entry, empty if names are full paths (Quick Access, This PC)
+			StringArena names; // UTF-8, relative to directory
+			StringArena searchKeys; // case folded file names
+			StringArena sortKeys; // searchKeys with digit runs encoded for natural ordering, see naturalSortKey()
+			std::vector<uint16_t> typeKeyLengths; // the type key (folded extension) is the tail of the search key
+			std::vector<uint8_t> directoryFlags;
+			std::vector<uint64_t> sizes; // bytes, 0 for directories
+			std::vector<time_t> datesModified;
+			std::vector<time_t> datesCreated; // 0 if the file system doesn't report a birth time
+			std::vector<uint64_t> searchMasks; // characters present in searchKeys, see characterMask()
+		};
+
+		// One entry of the filter combo box, compiled once by m_parseFilter. Plain extensions go to a hash set,
+		// everything else is a glob, both are matched against case folded names so nothing is allocated.
+		struct FilterMatcher {
+			struct StringHash {
+				using is_transparent = void;
+				inline size_t operator()(std::string_view text) const noexcept { return std::hash<std::string_view>{}(text); }
+			};
+
+			struct GlobToken {
+				enum class Kind : uint8_t {
+					literal,
+					anyRun, // *
+					anyCharacter, // ?
+					digit, // #
+					set // [a-z0-9], [!...] negates
+				};
+
+				GlobToken(Kind kind) : kind{kind} {}
+
+				Kind kind;
+				std::string literal;
+				std::array<uint64_t, 4> set{}; // one bit per byte
+			};
+
+			struct Glob {
+				std::vector<GlobToken> tokens;
+				size_t minLength = 0; // bytes any match needs at least
+			};
+
+			void add(std::string_view pattern); // ".png", "*_final.exr", "frame_####.png", ...
+			bool matches(std::string_view name, std::string_view extension) const; // case folded, the extension without its dot
+			static bool matchGlob(const Glob& glob, std::string_view name);
+
+			std::string defaultExtension; // first plain extension as written, save dialogs append it
+			bool matchAll = true; // until a pattern is added, and for "*" or ".*"
+			bool hasPatterns = false;
+			std::unordered_set<std::string, StringHash, std::equal_to<>> extensions; // folded, without the dot
+			std::vector<Glob> globs;
+		};
+
+		// Icons scaled to one size and packed into a few shared textures, so rows of different file types
+		// draw from the same texture. Pages get taller as they fill up, changed pages are uploaded again by
+		// m_syncIconAtlas once per frame.
+		struct IconAtlas {
+			struct Slot {
+				uint32_t page;
+				uint32_t cell;
+			};
+
+			struct Page {
+				std::vector<uint8_t> pixels; // RGBA, rows of cells
+				uint32_t rows = 0;
+				uint32_t uploadedRows = 0; // rows texture was created with, the uv rectangles are relative to them
+				void* texture = nullptr;
+				uint32_t usedCells = 0;
+				uint32_t nextCell = 0; // cells from here on were never used
+				std::vector<uint32_t> freeCells;
+				std::vector<uint32_t> releasedCells; // still shown by texture, reused after the next upload
+				bool dirty = false; // pixels changed since the upload
+			};
+
+			std::optional<Slot> allocate(size_t pageCount); // a free cell on one of the first pageCount pages, grows or adds pages
+			void write(Slot slot, const uint8_t* data, int width, int height, Format format); // scaled to fit the cell
+			void copy(Slot from, Slot to);
+			void release(Slot slot);
+			void fillCellBorder(Slot slot);
+			uint8_t* cellPixels(Slot slot);
+
+			std::vector<Page> pages;
+			std::vector<void*> retiredTextures; // may still be drawn this frame, deleted by the next m_syncIconAtlas
+		};
+
+		// an atlas page and the uv rectangle of the icon on it
+		struct IconImage {
+			void* texture = nullptr;
+			float uv0[2] = {0.0f, 0.0f};
+			float uv1[2] = {1.0f, 1.0f};
+		};
+
+		// only entries that have a decoded image preview get one
+		struct IconPreview {
+			void* texture;
+			uint8_t* data; // owned until uploaded to texture
+			int width, height;
+		};
+
+		enum class SortColumn : unsigned int {
+			name = 0,
+			date,
+			size,
+			type
+		};
+
+		struct SortSpec {
+			SortColumn column;
+			int direction; // ImGuiSortDirection
+		};
+
+		struct DirectoryStamp {
+			DirectoryStamp() = default;
+			DirectoryStamp(const std::filesystem::path& path);
+
+			bool operator==(const DirectoryStamp& others) const = default;
+
+			bool valid = false;
+			int64_t dateModified = 0; // nanoseconds
+			uint64_t device = 0;
+			uint64_t inode = 0;
+		};
+
+		struct FolderSize {
+			uint64_t bytes = 0; // regular files only, links aren't followed
+			uint64_t entries = 0; // files, folders and links below, recursively
+		};
+
+		// State shared by the render thread and a detached loader. The render thread never waits for a
+		// loader, it clears running and lets go, so one stuck in a hung mount can't take the UI with it.
+		template <typename T>
+		struct LoaderState {
+			std::atomic<bool> running{true}; // cleared by the loader when it's done, or by whoever stops it
+			std::atomic<uint64_t> progress{0}; // entries read so far, a loader that stops counting is stuck
+			std::mutex mutex;
+			T pending; // handed over to the render thread, guarded by mutex
+		};
+		// reads the listing index first, if it has the directory m_syncContent shows that while the rest is read
+		struct IndexedListing {
+			Listing content;
+			DirectoryStamp stamp;
+		};
+		struct ContentLoader : LoaderState<Listing> {
+			std::unique_ptr<IndexedListing> indexed; // guarded by mutex, set before any entries
+		};
+		using PreviewLoader = LoaderState<std::vector<std::pair<uint32_t, IconPreview>>>;
+		using FolderSizeLoader = LoaderState<std::vector<std::pair<uint32_t, FolderSize>>>;
+
+		struct IconCacheEntry {
+			std::string key;
+			IconAtlas::Slot slot;
+		};
+
+		// icon name to file for one icon theme, built by the first lookup on whichever thread makes it (Linux)
+		struct IconThemeIndex {
+			std::string theme;
+			std::once_flag built;
+			std::unordered_map<std::string, std::filesystem::path> files;
+		};
+
+		struct IconRequest {
+			std::string path;
+			std::string extension; // folded, empty unless files of this type share an icon
+			bool isFile;
+		};
+
+		// an icon m_loadIcons looked up and decoded, m_syncIcons adds it to the atlas
+		struct LoadedIcon {
+			std::string path; // as m_icons knows it
+			std::string extension;
+			std::string key; // m_iconCache key, empty if the file system had no icon
+			uint8_t* data = nullptr; // RGBA, owned until added, nullptr if it couldn't be decoded or wasn't tried
+			int width = 0, height = 0;
+			bool isFile = false;
+			bool timedOut = false; // its mount didn't answer
+			bool decodeSkipped = false; // the key was known already, data is nullptr
+		};
+		using IconLoader = LoaderState<std::vector<LoadedIcon>>;
+
+		// the icon cache file as it was read, its bitmaps are added to the atlas straight from the mapping
+		struct IconCacheFile {
+			std::string theme;
+			std::optional<uint64_t> themeStamp; // of the theme now, unknown if its directories didn't answer
+			std::shared_ptr<const void> mapping; // keeps bitmaps and checksums mapped
+			const uint8_t* bitmaps = nullptr;
+			const char* checksums = nullptr; // one per bitmap, checked when it's read
+			std::unordered_map<std::string, uint32_t> icons; // by icon key, index of the bitmap
+			std::unordered_map<std::string, std::string> extensionKeys; // folded extension to icon key
+			uint64_t contents = 0; // sum of iconCacheEntryHash() over the entries last read or written
+		};
+
+		// outlives the folder size loaders that fill it
+		struct FolderSizeCache {
+			std::mutex mutex;
+			std::unordered_map<std::string, std::pair<DirectoryStamp, FolderSize>> entries; // by path, valid while the stamp matches
+		};
 
-			bool hasIconPreview;
-			void* iconPreview;
-			uint8_t* iconPreviewData;
-			int iconPreviewWidth, iconPreviewHeight;
+		struct ListingCacheEntry {
+			std::string key;
+			DirectoryStamp stamp;
+			Listing content;
+			size_t bytes;
 		};
 
 		std::string m_currentKey;
@@ -124,42 +379,168 @@ namespace ifd {
 		std::stack<std::filesystem::path> m_backHistory;
 		std::stack<std::filesystem::path> m_forwardHistory;
 		float m_zoom;
-		std::vector<std::filesystem::path> m_selections;
+		std::vector<uint64_t> m_selectionBits; // one bit per m_content entry
+		size_t m_selectionCount;
+		int64_t m_selectionAnchor; // m_content index shift-click ranges start from, -1 if none
 		int m_selectedFileItem;
-		std::vector<std::filesystem::path> m_result;
+		std::filesystem::path m_resultDirectory;
+		StringArena m_resultNames; // relative to m_resultDirectory (or absolute)
+		std::vector<std::filesystem::path> m_result; // filled by getResults()
 		std::string m_filter;
-		std::vector<std::vector<std::string>> m_filterExtensions;
+		std::vector<FilterMatcher> m_filters; // one per entry of m_filter
 		size_t m_filterSelection;
-		std::unordered_map<std::string, void*> m_icons;
-		std::thread m_previewLoader;
-		bool m_previewLoaderRunning;
+		std::unordered_map<std::string, const IconAtlas::Slot*> m_icons; // by path, borrowed from m_iconCache
+		std::list<IconCacheEntry> m_iconCache; // by icon key (themed names, system image index, ...), most recently used first
+		std::unordered_map<std::string, std::list<IconCacheEntry>::iterator> m_iconCacheIndex;
+		size_t m_iconCacheMaxIcons;
+		size_t m_iconCacheMaxBytes;
+		uint64_t m_iconCacheHits;
+		uint64_t m_iconCacheMisses;
+		uint32_t m_defaultIconTint; // ImGuiCol_Text the default icons in m_iconCache were drawn with
+		IconAtlas m_iconAtlas;
+		std::unordered_map<std::string, std::string> m_iconExtensionKeys; // folded extension to icon key, files of one type share an icon
+		std::shared_ptr<PreviewLoader> m_previewLoader; // decodes images, the render thread uploads them
+		std::unordered_map<uint32_t, IconPreview> m_iconPreviews; // by m_content index
 		std::vector<std::unique_ptr<FileTreeNode>> m_treeCache;
-		unsigned int m_sortColumn;
-		unsigned int m_sortDirection;
-		std::vector<FileData> m_content;
+		std::vector<SortSpec> m_sortSpecs; // primary column first
+		size_t m_sortThreads; // 0 for hardware_concurrency()
+		Listing m_content;
+		std::shared_ptr<ContentLoader> m_contentLoader; // its listing is moved into m_content by m_syncContent
+		bool m_contentLoading;
+		bool m_contentRevalidating; // m_content came from the listing index, m_contentLoader reads the directory again
+		DirectoryStamp m_contentRevalidationStamp; // taken when the directory was read again
+		uint64_t m_contentProgress; // of m_contentLoader when last seen moving
+		std::chrono::steady_clock::time_point m_contentProgressTime;
+		std::vector<uint32_t> m_order; // m_content indices in sort order, m_content itself is never reordered
+		std::vector<uint32_t> m_orderRank; // position of every m_content entry in m_order
+		std::vector<uint32_t> m_view; // indices of the m_content entries that pass the search and the filter, sorted (or ranked while searching)
+		std::string m_viewQuery; // case folded search query m_view was built with
+		uint64_t m_viewQueryMask;
+		bool m_searchSubfolders; // "Subfolders" checkbox next to the search box
+		bool m_searchingSubfolders; // m_content holds the results of a recursive search, as full paths
+		std::vector<bool> m_contentRemoved; // tombstones left by m_applyChanges, indices are never reused
+		std::unordered_multimap<size_t, uint32_t> m_contentNameIndex; // name hash to m_content index, built on first change
+		int m_watchFd; // inotify instance, -1 if the directory is polled
+		DirectoryStamp m_watchStamp;
+		std::chrono::steady_clock::time_point m_watchPolled;
+		bool m_folderSizesEnabled;
+		std::shared_ptr<FolderSizeLoader> m_folderSizeLoader; // hands over sizes by m_content index
+		std::shared_ptr<FolderSizeCache> m_folderSizeCache;
+		std::unordered_map<uint32_t, FolderSize> m_contentFolderSizes; // by m_content index, only folders measured so far
+		FolderSize m_folderSizeTotal; // of the current directory, including its own files
+		size_t m_folderSizesCount;
+		size_t m_folderSizesDone;
+		std::string m_displayText; // date and size columns of the entries drawn so far, "date\0size\0" each
+		std::vector<uint32_t> m_displayTextOffsets; // into m_displayText by m_content index, NO_DISPLAY_TEXT until first drawn
+		std::string m_displayLocale; // time zone and numeric locale m_displayText was formatted with
+		std::string m_contentListingKey;
+		DirectoryStamp m_contentListingStamp;
+		std::list<ListingCacheEntry> m_listingCache; // most recently used first
+		std::unordered_map<std::string, std::list<ListingCacheEntry>::iterator> m_listingCacheIndex;
+		size_t m_listingCacheEntries;
+		size_t m_listingCacheBytes;
+		size_t m_listingCacheMaxEntries;
+		size_t m_listingCacheMaxBytes;
+		std::filesystem::path m_listingIndexPath; // empty if listings aren't persisted
+		size_t m_listingIndexMaxBytes;
+		std::filesystem::path m_iconCacheFilePath; // empty if icons aren't persisted
+		size_t m_iconCacheFileMaxBytes;
+		IconCacheFile m_iconCacheFile;
+		std::unordered_set<std::string> m_unresponsiveMounts; // see mountOf(), calls there fail at once until retried
 		bool confirmationPopup = false;
-		std::unordered_map<std::string, std::unordered_map<std::string, std::filesystem::path>> m_iconPathCache;
+		std::shared_ptr<IconThemeIndex> m_iconThemeIndex; // of the current theme, shared with m_iconLoader (Linux)
+		std::shared_ptr<IconLoader> m_iconLoader; // resolves and decodes icons, m_syncIcons takes them
+		std::vector<IconRequest> m_iconRequests; // for the next m_iconLoader
+		std::unordered_set<std::string> m_iconsRequested; // paths queued or loading, drawn with a default icon meanwhile
+		std::unordered_set<std::string> m_failedIconKeys; // couldn't be located or decoded, not tried again until the theme changes
 		
 		FileDialog();
-		void m_select(const std::filesystem::path& path, bool isCtrlDown = false);
+		void m_select(uint32_t index, bool isCtrlDown = false, bool isShiftDown = false);
+		void m_selectAll();
+		bool m_isSelected(uint32_t index) const;
+		bool m_isSelectable(uint32_t index) const;
+		void m_setSelected(uint32_t index, bool selected);
+		void m_updateSelectionText();
+		void m_clearSelection();
+		bool m_selectionExists();
 		bool m_finalize(const std::string& filename = "");
 		void m_parseFilter(const std::string& filter);
-		void* m_getIcon(const std::filesystem::path& path);
-		void m_loadDefaultIcon(const std::filesystem::path& path, const std::string& pathU8);
+		IconImage m_getIcon(const std::filesystem::path& path, bool isFile = false); // files with an extension are looked up by type
+		const IconAtlas::Slot* m_iconSlot(const std::string& key, const std::function<std::optional<IconAtlas::Slot>()>& load); // counts hits and misses
+		const IconAtlas::Slot* m_findIcon(const std::string& key);
+		const IconAtlas::Slot* m_findCachedIcon(const std::string& key); // in memory or in the icon cache file
+		const IconAtlas::Slot* m_storeIcon(const std::string& key, IconAtlas::Slot slot);
+		void m_trimIconCache();
+		void m_forgetIconPaths(); // the cached icons stay
+		std::optional<IconAtlas::Slot> m_readIconCacheFile(const std::string& key);
+		void m_writeIconCacheFile();
+		std::optional<IconAtlas::Slot> m_addIcon(const uint8_t* data, int width, int height, Format format);
+		IconImage m_iconImage(const IconAtlas::Slot* slot) const;
+		const IconAtlas::Slot* m_loadDefaultIcon(bool isFolder);
+		void m_syncDefaultIcons();
 		void m_clearIcons();
+		void m_uploadIconPage(IconAtlas::Page& page);
+		void m_syncIconAtlas();
+		void m_compactIconAtlas();
 		void m_refreshIconPreview();
 		void m_clearIconPreview();
 		void m_stopPreviewLoader();
-		void m_loadPreview();
+		static void m_loadPreview(std::shared_ptr<PreviewLoader> loader, std::vector<std::pair<uint32_t, std::filesystem::path>> entries);
+		void m_syncPreview();
 		void m_renderTree(FileTreeNode& node);
 		void m_setDirectory(const std::filesystem::path& p, bool addHistory = true);
-		void m_sortContent(unsigned int column, unsigned int sortDirection);
+		void m_resetContent();
+		void m_search();
+		static void m_searchContent(std::shared_ptr<ContentLoader> loader, std::filesystem::path root, std::string query);
+		void m_startContentLoader(std::function<void(std::shared_ptr<ContentLoader>)> load);
+		void m_stopContentLoader();
+		static void m_loadContent(std::shared_ptr<ContentLoader> loader, std::filesystem::path directory);
+		void m_syncContent();
+		void m_revalidateContent();
+		static bool m_readListingIndex(const std::filesystem::path& root, const std::string& key, Listing& content, DirectoryStamp& stamp);
+		void m_writeListingIndex(const std::string& key, const DirectoryStamp& stamp, const Listing& content);
+		bool m_matchesFilter(uint32_t index) const;
+		int m_matchQuery(uint32_t index) const;
+		void m_updateView(bool rebuild);
+		const Listing* m_findListing(const std::string& key, const DirectoryStamp& stamp);
+		void m_storeListing(const std::string& key, const DirectoryStamp& stamp, Listing&& content);
+		void m_eraseListing(const std::string& key);
+		void m_trimListingCache();
+		void m_startWatch();
+		void m_stopWatch();
+		void m_syncWatch();
+		void m_rescanContent(bool everything);
+		void m_applyChanges(std::vector<std::string> names); // names of entries that were added, removed or modified
+		void m_reorderContent(std::vector<uint32_t> moved);
+		void m_startFolderSizes();
+		void m_stopFolderSizes();
+		static void m_loadFolderSizes(std::shared_ptr<FolderSizeLoader> loader, std::shared_ptr<FolderSizeCache> cache, std::vector<std::pair<uint32_t, std::filesystem::path>> folders);
+		void m_syncFolderSizes();
+		uint64_t m_entrySize(uint32_t index) const;
+		int64_t m_findEntry(std::string_view name);
+		bool m_isRemoved(uint32_t index) const;
+		bool m_compareContent(uint32_t left, uint32_t right) const;
+		void m_sortContent();
+		std::pair<const char*, const char*> m_getDisplayText(uint32_t index); // date and size, formatted on first use
+		void m_checkDisplayLocale();
+		void m_clearDisplayText();
+		template <typename Call>
+		auto m_callFileSystem(const std::filesystem::path& path, std::chrono::milliseconds timeout, Call call) -> std::optional<decltype(call())>;
+		bool m_exists(const std::filesystem::path& path); // false if it doesn't answer either
+		bool m_isResponsive(const std::filesystem::path& path) const;
+		void m_retryDirectory();
+		void m_abandonDirectory();
 		void m_renderContent();
 		void m_renderPopups();
 		void m_renderFileDialog();
 
 #ifdef __linux__
-		std::filesystem::path m_locateIcon(const std::string& iconName, int size);
+		static std::filesystem::path m_locateIcon(IconThemeIndex& index, const std::string& iconName);
+		void m_syncIconTheme();
+		void m_openIconCacheFile(const std::string& theme);
+		static void m_loadIcons(std::shared_ptr<IconLoader> loader, std::vector<IconRequest> requests, std::unordered_set<std::string> knownKeys, std::shared_ptr<IconThemeIndex> themeIndex);
+		void m_syncIcons();
+		void m_stopIconLoader();
 #endif
 	};
 }
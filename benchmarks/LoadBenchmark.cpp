@@ -0,0 +1,110 @@
+// Reads a directory of generated files the way the FileData constructor used to (a directory_iterator and three
+// stats of the full path per entry) and with m_loadContent, warm cache, best of a few runs. The system calls can be
+// counted by running it under `strace -c -f`.
+// usage: LoadBenchmark [entries = 100000] [directory = <temp>/ImFileDialogLoadBenchmark]
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+
+#define private public
+#include "ImFileDialog.cpp"
+#undef private
+
+namespace {
+	constexpr int RUNS = 5;
+
+	// a tenth of them folders, the files of a few sizes
+	void generate(const std::filesystem::path& directory, size_t entries)
+	{
+		std::error_code ec;
+		size_t existing = 0;
+		for (std::filesystem::directory_iterator it{directory, ec}; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			existing++;
+		}
+		if (existing == entries) {
+			return;
+		}
+
+		std::filesystem::remove_all(directory, ec);
+		std::filesystem::create_directories(directory);
+		for (size_t i = 0; i < entries; i++) {
+			const auto name = directory / ("entry" + std::to_string(i));
+			if (i % 10 == 0) {
+				std::filesystem::create_directory(name, ec);
+			} else {
+				std::ofstream(name) << std::string(i % 97, 'x');
+			}
+		}
+	}
+
+	size_t loadLikeFileData(const std::filesystem::path& directory)
+	{
+		size_t bytes = 0;
+		std::error_code ec;
+		for (std::filesystem::directory_iterator it{directory, ec}; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+			const auto path = it->path();
+			const bool isDirectory = std::filesystem::is_directory(path, ec);
+			const auto size = isDirectory ? 0 : std::filesystem::file_size(path, ec);
+			struct stat attr;
+			stat(path.u8string().c_str(), &attr);
+			bytes += size + (attr.st_mtime & 1);
+		}
+		return bytes;
+	}
+
+	size_t loadContent(const std::filesystem::path& directory)
+	{
+		auto loader = std::make_shared<ifd::FileDialog::ContentLoader>();
+		loader->running = true;
+		ifd::FileDialog::m_loadContent(loader, directory);
+
+		size_t bytes = 0;
+		for (size_t i = 0; i < loader->pending.size(); i++) {
+			bytes += loader->pending.sizes[i] + (loader->pending.datesModified[i] & 1);
+		}
+		return bytes;
+	}
+
+	double best(const std::function<size_t()>& run)
+	{
+		double result = 0;
+		for (int i = 0; i < RUNS; i++) {
+			const auto start = std::chrono::steady_clock::now();
+			volatile size_t sink = run();
+			(void)sink;
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			result = i == 0 ? ms : std::min(result, ms);
+		}
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t entries = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+	const std::filesystem::path directory = argc > 2 ? argv[2] : std::filesystem::temp_directory_path() / "ImFileDialogLoadBenchmark";
+	generate(directory, entries);
+
+	const double old = best([&]() { return loadLikeFileData(directory); });
+	const double now = best([&]() { return loadContent(directory); });
+	const double scale = 100000.0 / static_cast<double>(entries);
+	printf("%zu entries in %s\n", entries, directory.c_str());
+	printf("  FileData constructor  %8.1f ms  (%.1f ms per 100k entries)\n", old, old * scale);
+	printf("  m_loadContent         %8.1f ms  (%.1f ms per 100k entries)\n", now, now * scale);
+	return 0;
+}
@@ -0,0 +1,79 @@
+// Sorts synthetic listings of 10k, 100k and 1M entries by name and by size with m_sortContent on 1, 4 and 16
+// threads (see setSortThreads), best of a few runs. Nothing is read from disk.
+// usage: SortBenchmark
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <cstdio>
+
+#define private public
+#include "ImFileDialog.cpp"
+#undef private
+
+namespace {
+	constexpr int RUNS = 3;
+
+	// names like a download folder: words, numbers that sort naturally, a few extensions, a tenth folders
+	ifd::FileDialog::Listing generate(size_t entries)
+	{
+		static const char* words[] = {"report", "IMG_", "Scan ", "backup-", "Übersicht", "notes", "track", "photo"};
+		static const char* extensions[] = {".txt", ".png", ".jpg", ".pdf", ".tar.gz", ""};
+
+		std::mt19937 random{42};
+		ifd::FileDialog::Listing listing;
+		for (size_t i = 0; i < entries; i++) {
+			std::string name = words[random() % std::size(words)];
+			name += std::to_string(random() % 100000);
+			const bool isDirectory = i % 10 == 0;
+			if (!isDirectory) {
+				name += extensions[random() % std::size(extensions)];
+			}
+			listing.add(name, isDirectory, isDirectory ? 0 : random() % (1 << 30), static_cast<time_t>(random()), 0);
+		}
+		return listing;
+	}
+}
+
+int main()
+{
+	ImGui::CreateContext();
+	auto* dialog = new ifd::FileDialog();
+	dialog->m_stopContentLoader();
+
+	printf("%10s %8s %8s %10s\n", "entries", "column", "threads", "ms");
+	for (size_t entries : {10000, 100000, 1000000}) {
+		dialog->m_content = generate(entries);
+		dialog->m_displayTextOffsets.clear();
+
+		for (const auto column : {ifd::FileDialog::SortColumn::name, ifd::FileDialog::SortColumn::size}) {
+			dialog->m_sortSpecs = {ifd::FileDialog::SortSpec{column, ImGuiSortDirection_Ascending}};
+			for (size_t threads : {1, 4, 16}) {
+				dialog->setSortThreads(threads);
+
+				double best = 0;
+				for (int i = 0; i < RUNS; i++) {
+					const auto start = std::chrono::steady_clock::now();
+					dialog->m_sortContent();
+					const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					best = i == 0 ? ms : std::min(best, ms);
+				}
+				printf("%10zu %8s %8zu %10.1f\n", entries, column == ifd::FileDialog::SortColumn::name ? "name" : "size", threads, best);
+			}
+		}
+	}
+	return 0;
+}
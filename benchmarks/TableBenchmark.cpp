@@ -0,0 +1,107 @@
+// Renders the list view of synthetic listings of 1k, 100k and 1M entries headlessly, first standing at the top and
+// then scrolling with the mouse wheel on every frame, and prints the mean and worst CPU time of a frame
+// (NewFrame to Render, no GPU). Icons stay the default ones, the icon loader isn't synced.
+// usage: TableBenchmark [frames = 300]
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+
+#define private public
+#include "ImFileDialog.cpp"
+#undef private
+
+namespace {
+	constexpr int WARMUP_FRAMES = 10;
+
+	ifd::FileDialog::Listing generate(const std::filesystem::path& directory, size_t entries)
+	{
+		ifd::FileDialog::Listing listing;
+		listing.directory = directory;
+		for (size_t i = 0; i < entries; i++) {
+			const bool isDirectory = i % 10 == 0;
+			listing.add("entry" + std::to_string(i) + (isDirectory ? "" : ".txt"), isDirectory, i * 37, static_cast<time_t>(1700000000 + i), 0);
+		}
+		return listing;
+	}
+
+	// mean and worst in ms
+	std::pair<double, double> render(ifd::FileDialog& dialog, int frames, float wheel)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		double total = 0, worst = 0;
+		for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+			io.AddMousePosEvent(io.DisplaySize.x / 2, io.DisplaySize.y / 2);
+			io.AddMouseWheelEvent(0.0f, wheel);
+
+			const auto start = std::chrono::steady_clock::now();
+			ImGui::NewFrame();
+			ImGui::SetNextWindowPos(ImVec2(0, 0));
+			ImGui::SetNextWindowSize(io.DisplaySize);
+			ImGui::Begin("##benchmark", nullptr, ImGuiWindowFlags_NoDecoration);
+			dialog.m_renderContent();
+			ImGui::End();
+			ImGui::Render();
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (frame >= WARMUP_FRAMES) {
+				total += ms;
+				worst = std::max(worst, ms);
+			}
+		}
+		return {total / frames, worst};
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(1920, 1080);
+	io.DeltaTime = 1.0f / 60.0f;
+	io.IniFilename = nullptr;
+	unsigned char* pixels = nullptr;
+	int width = 0, height = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	auto* dialog = new ifd::FileDialog();
+	dialog->m_stopContentLoader();
+	dialog->createTexture = [](const uint8_t*, int, int, ifd::Format) -> void* {
+		static uintptr_t texture = 0;
+		return reinterpret_cast<void*>(++texture);
+	};
+	dialog->deleteTexture = [](void*) {};
+	dialog->m_zoom = ifd::ZOOM_LEVEL_LIST_VIEW;
+
+	const auto directory = std::filesystem::temp_directory_path() / "ImFileDialogTableBenchmark";
+	printf("%10s %10s %10s %10s %10s\n", "entries", "top mean", "top worst", "scroll mean", "scroll worst");
+	for (size_t entries : {1000, 100000, 1000000}) {
+		dialog->m_content = generate(directory, entries);
+		dialog->m_displayTextOffsets.clear();
+		dialog->m_displayText.clear();
+		dialog->m_sortContent();
+
+		const auto [topMean, topWorst] = render(*dialog, frames, 0.0f);
+		const auto [scrollMean, scrollWorst] = render(*dialog, frames, -5.0f);
+		printf("%10zu %10.3f %10.3f %10.3f %10.3f\n", entries, topMean, topWorst, scrollMean, scrollWorst);
+	}
+
+	ImGui::DestroyContext();
+	return 0;
+}
@@ -121,9 +121,9 @@ int main(int argc, char* argv[])
 		// file dialogs
 		if (ifd::FileDialog::getInstance().isDone("ShaderOpenDialog")) {
 			if (ifd::FileDialog::getInstance().hasResult()) {
-				const std::vector<std::filesystem::path>& res = ifd::FileDialog::getInstance().getResults();
-				for (const auto& r : res) {// ShaderOpenDialog supports multiselection
-					printf("OPEN[%s]\n", r.u8string().c_str());
+				size_t count = ifd::FileDialog::getInstance().getResultCount();
+				for (size_t i = 0; i < count; i++) {// ShaderOpenDialog supports multiselection
+					printf("OPEN[%s]\n", ifd::FileDialog::getInstance().getResult(i).u8string().c_str());
 				}
 			}
 			ifd::FileDialog::getInstance().close();
@@ -0,0 +1,135 @@
+// Checks that an icon which can't be decoded gets the default icon once, instead of being requeued forever.
+// Builds ImFileDialog.cpp in, its icon loader has no public hooks.
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <cstdio>
+#include <gio/gio.h>
+
+#define private public
+#include "ImFileDialog.cpp"
+#undef private
+
+#define CHECK(condition) \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+		return 1; \
+	}
+
+namespace {
+	// the themed names GIO gives the file, as m_loadIcons asks for them
+	std::vector<std::string> themedNames(const std::filesystem::path& path)
+	{
+		std::vector<std::string> result;
+		GFile* gFile = g_file_new_for_path(path.c_str());
+		GFileInfo* gFileInfo = g_file_query_info(gFile, G_FILE_ATTRIBUTE_STANDARD_ICON, G_FILE_QUERY_INFO_NONE, nullptr, nullptr);
+		GIcon* gIcon = gFileInfo != nullptr ? g_file_info_get_icon(gFileInfo) : nullptr;
+		if (gIcon != nullptr && G_IS_THEMED_ICON(gIcon)) {
+			const auto names = g_themed_icon_get_names(G_THEMED_ICON(gIcon));
+			for (int i = 0; names[i] != NULL; i++) {
+				result.emplace_back(names[i]);
+			}
+		}
+		if (gFileInfo != nullptr) {
+			g_object_unref(gFileInfo);
+		}
+		g_object_unref(gFile);
+		return result;
+	}
+
+	// runs frames until nothing is queued or loading, false if that doesn't happen
+	bool settle(ifd::FileDialog& dialog, const std::vector<std::filesystem::path>& files, int& loaders)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (std::chrono::steady_clock::now() < deadline) {
+			for (const auto& file : files) {
+				dialog.m_getIcon(file, true);
+			}
+
+			const bool running = dialog.m_iconLoader != nullptr;
+			dialog.m_syncIcons();
+			if (!running && dialog.m_iconLoader) {
+				loaders++;
+			}
+			if (!dialog.m_iconLoader && dialog.m_iconRequests.empty() && dialog.m_iconsRequested.empty()) {
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+}
+
+int main()
+{
+	const auto directory = std::filesystem::temp_directory_path() / "ImFileDialogIconLoaderTest";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	// every name of the type points at a file that isn't an image
+	const auto broken = directory / "broken.png";
+	std::ofstream(broken) << "not a png";
+	std::vector<std::filesystem::path> files;
+	for (const char* name : {"a.png", "b.png", "c.png"}) {
+		files.push_back(directory / name);
+		std::ofstream(files.back()) << "not a png either";
+	}
+
+	const auto names = themedNames(files[0]);
+	if (names.empty()) {
+		fprintf(stderr, "GIO has no themed icon for %s, skipped\n", files[0].c_str());
+		return 77;
+	}
+
+	ImGui::CreateContext();
+	ifd::FileDialog& dialog = ifd::FileDialog::getInstance();
+	dialog.createTexture = [](const uint8_t*, int, int, ifd::Format) -> void* {
+		static uintptr_t texture = 0;
+		return reinterpret_cast<void*>(++texture);
+	};
+	dialog.deleteTexture = [](void*) {};
+
+	// the theme isn't read from GSettings, the index is what m_loadIcons would have built
+	dialog.m_iconThemeIndex = std::make_shared<ifd::FileDialog::IconThemeIndex>();
+	std::call_once(dialog.m_iconThemeIndex->built, [&]() {
+		for (const auto& name : names) {
+			dialog.m_iconThemeIndex->files[name] = broken;
+		}
+	});
+
+	// one loader for the two files, the second shares the first one's key
+	int loaders = 0;
+	CHECK(settle(dialog, {files[0], files[1]}, loaders));
+	CHECK(loaders == 1);
+	CHECK(dialog.m_failedIconKeys.size() == 1);
+	CHECK(!dialog.m_iconCacheIndex.contains(*dialog.m_failedIconKeys.begin()));
+	CHECK(dialog.m_icons.at(files[0].u8string()) == dialog.m_loadDefaultIcon(false));
+	CHECK(dialog.m_icons.at(files[1].u8string()) == dialog.m_loadDefaultIcon(false));
+
+	// a later file of the type goes to a new loader, which knows the key failed
+	CHECK(settle(dialog, {files[2]}, loaders));
+	CHECK(loaders == 2);
+	CHECK(dialog.m_failedIconKeys.size() == 1);
+	CHECK(dialog.m_icons.at(files[2].u8string()) == dialog.m_loadDefaultIcon(false));
+
+	// a theme change tries them again
+	dialog.m_clearIcons();
+	CHECK(dialog.m_failedIconKeys.empty());
+
+	ImGui::DestroyContext();
+	std::filesystem::remove_all(directory);
+	return 0;
+}